@@ -15,7 +15,13 @@ GEN_PATH = $(RTL_PATH)/src/gen
 ifeq ($(TOP),CoreNSoC)
 VERILOG_SRCS += $(RTL_PATH)/src/gen/CoreNSoC.v
 VERILOG_SRCS += $(RTL_PATH)/src/verilog/dpi/CoreNDpi.sv
-VERILOG_SRCS += $(RTL_PATH)/src/verilog/dpi/RamDpi.sv
+VERILOG_SRCS += $(RTL_PATH)/src/verilog/dpi/RamBurstDpi.sv
+endif
+
+ifeq ($(TOP),CorePSoC)
+VERILOG_SRCS += $(RTL_PATH)/src/gen/CorePSoC.v
+VERILOG_SRCS += $(RTL_PATH)/src/verilog/dpi/CoreNDpi.sv
+VERILOG_SRCS += $(RTL_PATH)/src/verilog/dpi/RamBurstDpi.sv
 endif
 
 ifeq ($(TOP),ysyxSoCFull)
@@ -29,5 +35,8 @@ SCALA_SRCS += $(wildcard $(RTL_PATH)/src/spinal/*/*/*.scala)
 $(GEN_PATH)/CoreNSoC.v: $(SCALA_SRCS)
 	cd $(RTL_PATH) && sbt "runMain soc.CoreNSoCVerilog"
 
+$(GEN_PATH)/CorePSoC.v: $(SCALA_SRCS)
+	cd $(RTL_PATH) && sbt "runMain soc.CorePSoCVerilog"
+
 $(GEN_PATH)/YsyxSoC.v: $(SCALA_SRCS)
 	cd $(RTL_PATH) && sbt "runMain soc.YsyxSoCVerilog"
\ No newline at end of file
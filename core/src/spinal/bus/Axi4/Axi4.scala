@@ -0,0 +1,113 @@
+/* ------------------------------------------------------------------------------------------------
+ * Copyright (c) 2023. Heqing Huang (feipenghhq@gmail.com)
+ *
+ * Project: NPC
+ * Author: Heqing Huang
+ * Date Created: 10/18/2026
+ *
+ * ------------------------------------------------------------------------------------------------
+ * Axi4: AXI4 bus with burst support
+ * ------------------------------------------------------------------------------------------------
+ * Only the signals used in this project are defined. Lock, cache, qos, region and user signals
+ * are not supported.
+ * ------------------------------------------------------------------------------------------------
+ */
+
+package bus.Axi4
+
+import spinal.core._
+import spinal.lib._
+
+case class Axi4Config(
+    addrWidth: Int = 32,    // Address width
+    dataWidth: Int = 32,    // Data width
+    idWidth: Int = 4,       // ID width
+    outstanding: Int = 1    // number of supported outstanding transaction
+) {
+    def AW = addrWidth
+    def DW = dataWidth
+    def IW = idWidth
+    def bytePerBeat = dataWidth / 8
+    def fullSize = log2Up(bytePerBeat)  // AxSIZE of a full data width transfer
+}
+
+object Axi4 {
+    // AxBURST encoding
+    def FIXED = B"00"
+    def INCR  = B"01"
+    def WRAP  = B"10"
+
+    // xRESP encoding
+    def OKAY   = B"00"
+    def EXOKAY = B"01"
+    def SLVERR = B"10"
+    def DECERR = B"11"
+}
+
+case class Axi4Ar(config: Axi4Config) extends Bundle {
+    val araddr  = UInt(config.AW bits)
+    val arid    = UInt(config.IW bits)
+    val arlen   = UInt(8 bits)
+    val arsize  = UInt(3 bits)
+    val arburst = Bits(2 bits)
+    val arprot  = Bits(3 bits)
+}
+
+case class Axi4R(config: Axi4Config) extends Bundle {
+    val rdata = Bits(config.DW bits)
+    val rid   = UInt(config.IW bits)
+    val rresp = Bits(2 bits)
+    val rlast = Bool()
+}
+
+case class Axi4Aw(config: Axi4Config) extends Bundle {
+    val awaddr  = UInt(config.AW bits)
+    val awid    = UInt(config.IW bits)
+    val awlen   = UInt(8 bits)
+    val awsize  = UInt(3 bits)
+    val awburst = Bits(2 bits)
+    val awprot  = Bits(3 bits)
+}
+
+case class Axi4W(config: Axi4Config) extends Bundle {
+    val wdata = Bits(config.DW bits)
+    val wstrb = Bits(config.DW/8 bits)
+    val wlast = Bool()
+}
+
+case class Axi4B(config: Axi4Config) extends Bundle {
+    val bid   = UInt(config.IW bits)
+    val bresp = Bits(2 bits)
+}
+
+case class Axi4(config: Axi4Config) extends Bundle with IMasterSlave {
+    val ar = Stream(Axi4Ar(config))
+    val r  = Stream(Axi4R(config))
+    val aw = Stream(Axi4Aw(config))
+    val w  = Stream(Axi4W(config))
+    val b  = Stream(Axi4B(config))
+
+    def asMaster() {
+        master(ar, aw, w)
+        slave(r, b)
+    }
+
+    /**
+      * Functions to help rename the AXI signals in the generated verilog code
+      *
+      * @param prefix the prefix name to the AXI signal
+      */
+    def updateSignalName(prefix: String): Axi4 = {
+        def setName[T<:Bundle](channel: => Stream[T]) {
+            channel.valid.setName(prefix + "_" + channel.name + "valid")
+            channel.ready.setName(prefix + "_" + channel.name + "ready")
+            channel.payload.elements.foreach(f => f._2.setName(prefix + "_" + f._1))
+        }
+        setName(ar)
+        setName(r)
+        setName(aw)
+        setName(w)
+        setName(b)
+        this
+    }
+}
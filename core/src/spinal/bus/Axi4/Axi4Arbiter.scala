@@ -0,0 +1,136 @@
+/* ------------------------------------------------------------------------------------------------
+ * Copyright (c) 2023. Heqing Huang (feipenghhq@gmail.com)
+ *
+ * Project: NPC
+ * Author: Heqing Huang
+ * Date Created: 10/18/2026
+ *
+ * ------------------------------------------------------------------------------------------------
+ * Axi4 Arbiter
+ * ------------------------------------------------------------------------------------------------
+ * 10/18/2026: Added outstanding transaction support
+ * Note:
+ * 1. Up to config.outstanding transactions can be in flight on each of the read and write side.
+ *    The index of the granted requester is recorded in an order queue when the request is accepted
+ *    and the response is routed back to the requester at the head of the queue. The slave should
+ *    return the responses in the request order.
+ * 2. The read and write channels are arbitrated independently.
+ * 3. The write arbitration is done on the AW channel. The W channel is routed to the requester of
+ *    the oldest AW request that has not sent the last beat.
+ * 4. The requesters can be weighted (see RrArbiter) to give more bandwidth to one of them.
+ * ------------------------------------------------------------------------------------------------
+ */
+package bus.Axi4
+
+import common._
+import spinal.core._
+import spinal.lib._
+import config._
+
+/**
+ * AXI4 Arbiter
+ * @param config  AXI config
+ * @param count   Number of host
+ * @param weights Arbitration weight of each host. Empty for the same weight
+ */
+case class Axi4Arbiter(config: Axi4Config, count: Int, weights: Seq[Int] = Seq()) extends Component {
+    val io = new Bundle {
+        val input = Vec(slave(Axi4(config)), count)
+        val output = master(Axi4(config))
+        val stall = out port Bool()     // a request is blocked by the arbitration. For performance counter
+        val arGrantId = out port UInt(log2Up(count) bits)   // the requester of the AR request on the output
+    }
+    noIoPrefix()
+
+    assert(count >= 2)
+
+    // channel alias
+    val ar = io.input.map((f: Axi4) => f.ar)
+    val r = io.input.map((f: Axi4) => f.r)
+    val aw = io.input.map((f: Axi4) => f.aw)
+    val w = io.input.map((f: Axi4) => f.w)
+    val b = io.input.map((f: Axi4) => f.b)
+
+    val arvalid = ar.map(_.valid).asBits
+    val awvalid = aw.map(_.valid).asBits
+
+    // arbiter on read channel
+    val readArb = new Area {
+        val arbiter = RrArbiter(count, weights)
+        arbiter.io.req <> arvalid
+        arbiter.io.enable := io.output.ar.fire
+
+        // order of the outstanding read requests. Popped at the last beat of the burst
+        val rOrder = StreamFifo(UInt(log2Up(count) bits), config.outstanding)
+        rOrder.io.push.valid := io.output.ar.fire
+        rOrder.io.push.payload := arbiter.io.grantId
+        rOrder.io.pop.ready := io.output.r.fire & io.output.r.payload.rlast
+    }
+
+    // arbiter on write channel
+    val writeArb = new Area {
+        val arbiter = RrArbiter(count, weights)
+        arbiter.io.req <> awvalid
+        arbiter.io.enable := io.output.aw.fire
+
+        // order of the outstanding write requests for the W channel. Popped at the last W beat
+        val wOrder = StreamFifo(UInt(log2Up(count) bits), config.outstanding)
+        wOrder.io.push.valid := io.output.aw.fire
+        wOrder.io.push.payload := arbiter.io.grantId
+        wOrder.io.pop.ready := io.output.w.fire & io.output.w.payload.wlast
+
+        // order of the outstanding write requests for the B channel
+        val bOrder = StreamFifo(UInt(log2Up(count) bits), config.outstanding)
+        bOrder.io.push.valid := io.output.aw.fire
+        bOrder.io.push.payload := arbiter.io.grantId
+        bOrder.io.pop.ready := io.output.b.fire
+    }
+
+    val arGrant    = readArb.arbiter.io.grant
+    val arGrantId  = readArb.arbiter.io.grantId
+    val arFull     = ~readArb.rOrder.io.push.ready
+    val rValid     = readArb.rOrder.io.pop.valid
+    val rId        = readArb.rOrder.io.pop.payload
+    val awGrant    = writeArb.arbiter.io.grant
+    val awGrantId  = writeArb.arbiter.io.grantId
+    val awFull     = ~(writeArb.wOrder.io.push.ready & writeArb.bOrder.io.push.ready)
+    val wValid     = writeArb.wOrder.io.pop.valid
+    val wId        = writeArb.wOrder.io.pop.payload
+    val bValid     = writeArb.bOrder.io.pop.valid
+    val bId        = writeArb.bOrder.io.pop.payload
+
+    // AR channel
+    ar.zipWithIndex.foreach(f => f._1.ready := io.output.ar.ready & arGrant(f._2) & ~arFull)
+    io.output.ar.valid := (arvalid & arGrant.asBits).orR & ~arFull
+    io.output.ar.payload := ar.map(_.payload).read(arGrantId)
+    io.arGrantId := arGrantId
+
+    // R channel
+    io.output.r.ready := r.map(_.ready).read(rId) & rValid
+    r.zipWithIndex.foreach(f => f._1.valid := io.output.r.valid & rValid & rId === f._2)
+    r.foreach(_.payload := io.output.r.payload)
+
+    // AW channel
+    aw.zipWithIndex.foreach(f => f._1.ready := io.output.aw.ready & awGrant(f._2) & ~awFull)
+    io.output.aw.valid := (awvalid & awGrant.asBits).orR & ~awFull
+    io.output.aw.payload := aw.map(_.payload).read(awGrantId)
+
+    // W channel
+    w.zipWithIndex.foreach(f => f._1.ready := io.output.w.ready & wValid & wId === f._2)
+    io.output.w.valid := w.map(_.valid).read(wId) & wValid
+    io.output.w.payload := w.map(_.payload).read(wId)
+
+    // B channel
+    io.output.b.ready := b.map(_.ready).read(bId) & bValid
+    b.zipWithIndex.foreach(f => f._1.valid := io.output.b.valid & bValid & bId === f._2)
+    b.foreach(_.payload := io.output.b.payload)
+
+    // A request is blocked when it is not granted or too many transactions are in flight
+    val arStall = ar.zipWithIndex.map(f => f._1.valid & ~(arGrant(f._2) & ~arFull)).asBits.orR
+    val awStall = aw.zipWithIndex.map(f => f._1.valid & ~(awGrant(f._2) & ~awFull)).asBits.orR
+    io.stall := arStall | awStall
+}
+
+object Axi4ArbiterVerilog extends App {
+    Config.spinal.generateVerilog(Axi4Arbiter(Axi4Config(outstanding = 4), 2, Seq(1, 2)))
+}
@@ -0,0 +1,244 @@
+/* ------------------------------------------------------------------------------------------------
+ * Copyright (c) 2023. Heqing Huang (feipenghhq@gmail.com)
+ *
+ * Project: NPC
+ * Author: Heqing Huang
+ * Date Created: 10/18/2026
+ *
+ * ------------------------------------------------------------------------------------------------
+ * Axi4 Bridge: Protocol and width bridges for the AXI4 bus
+ * ------------------------------------------------------------------------------------------------
+ * - Axi4LiteToAxi4: AXI4-Lite master to AXI4 slave. Each request is a single beat burst.
+ * - Axi4ToAxi4Lite: AXI4 master to AXI4-Lite slave. A burst is split into single requests.
+ * - Axi4Downsizer:  Wide AXI4 master to narrow AXI4 slave. Each wide beat is split into several
+ *                   narrow beats. Only full width INCR burst aligned to the wide data width is
+ *                   supported.
+ * ------------------------------------------------------------------------------------------------
+ */
+package bus.Axi4
+
+import spinal.core._
+import spinal.lib._
+import config._
+import _root_.bus.Axi4Lite._
+
+/**
+  * AXI4-Lite master to AXI4 slave
+  */
+case class Axi4LiteToAxi4(liteConfig: Axi4LiteConfig, config: Axi4Config) extends Component {
+    val io = new Bundle {
+        val input = slave(Axi4Lite(liteConfig))
+        val output = master(Axi4(config))
+    }
+    noIoPrefix()
+    assert(liteConfig.dataWidth == config.dataWidth)
+
+    // AR/R channel
+    io.output.ar.arbitrationFrom(io.input.ar)
+    io.output.ar.payload.araddr := io.input.ar.payload.araddr
+    io.output.ar.payload.arprot := io.input.ar.payload.arprot
+    io.output.ar.payload.arid := 0
+    io.output.ar.payload.arlen := 0
+    io.output.ar.payload.arsize := config.fullSize
+    io.output.ar.payload.arburst := Axi4.INCR
+
+    io.input.r.arbitrationFrom(io.output.r)
+    io.input.r.payload.rdata := io.output.r.payload.rdata
+    io.input.r.payload.rresp := io.output.r.payload.rresp
+
+    // AW/W/B channel
+    io.output.aw.arbitrationFrom(io.input.aw)
+    io.output.aw.payload.awaddr := io.input.aw.payload.awaddr
+    io.output.aw.payload.awprot := io.input.aw.payload.awprot
+    io.output.aw.payload.awid := 0
+    io.output.aw.payload.awlen := 0
+    io.output.aw.payload.awsize := config.fullSize
+    io.output.aw.payload.awburst := Axi4.INCR
+
+    io.output.w.arbitrationFrom(io.input.w)
+    io.output.w.payload.wdata := io.input.w.payload.wdata
+    io.output.w.payload.wstrb := io.input.w.payload.wstrb
+    io.output.w.payload.wlast := True
+
+    io.input.b.arbitrationFrom(io.output.b)
+    io.input.b.payload.bresp := io.output.b.payload.bresp
+}
+
+/**
+  * AXI4 master to AXI4-Lite slave
+  */
+case class Axi4ToAxi4Lite(config: Axi4Config, liteConfig: Axi4LiteConfig) extends Component {
+    val io = new Bundle {
+        val input = slave(Axi4(config))
+        val output = master(Axi4Lite(liteConfig))
+    }
+    noIoPrefix()
+    assert(liteConfig.dataWidth == config.dataWidth)
+
+    val read = new Area {
+        val active = Reg(Bool()) init False     // a burst is being served
+        val sent = Reg(Bool()) init False       // the lite request is sent, waiting for the data
+        val addr = Reg(UInt(config.AW bits))
+        val remain = Reg(UInt(8 bits))
+        val id = Reg(UInt(config.IW bits))
+
+        io.input.ar.ready := ~active
+        when(io.input.ar.fire) {
+            active := True
+            addr := io.input.ar.payload.araddr
+            remain := io.input.ar.payload.arlen
+            id := io.input.ar.payload.arid
+        }
+
+        io.output.ar.valid := active & ~sent
+        io.output.ar.payload.araddr := addr
+        io.output.ar.payload.arprot := 0
+        when(io.output.ar.fire) {
+            sent := True
+        }
+
+        io.input.r.arbitrationFrom(io.output.r)
+        io.input.r.payload.rdata := io.output.r.payload.rdata
+        io.input.r.payload.rresp := io.output.r.payload.rresp
+        io.input.r.payload.rid := id
+        io.input.r.payload.rlast := remain === 0
+        when(io.output.r.fire) {
+            sent := False
+            addr := addr + config.bytePerBeat
+            remain := remain - 1
+            when(remain === 0) {
+                active := False
+            }
+        }
+    }
+
+    val write = new Area {
+        val active = Reg(Bool()) init False     // a burst is being served
+        val busy = Reg(Bool()) init False       // the lite request is sent, waiting for the response
+        val last = Reg(Bool())                  // the lite request is the last beat
+        val bValid = Reg(Bool()) init False     // response of the burst
+        val bresp = Reg(Bits(2 bits))
+        val addr = Reg(UInt(config.AW bits))
+        val id = Reg(UInt(config.IW bits))
+
+        io.input.aw.ready := ~active
+        when(io.input.aw.fire) {
+            active := True
+            addr := io.input.aw.payload.awaddr
+            id := io.input.aw.payload.awid
+            bresp := Axi4.OKAY
+        }
+
+        // logic to make sure both AW and W channel completes handshake
+        val awDone = Reg(Bool()) init False
+        val wDone = Reg(Bool()) init False
+        val issue = active & io.input.w.valid & ~busy & ~bValid
+        val accepted = (io.output.aw.fire | awDone) & (io.output.w.fire | wDone)
+        when(io.output.aw.fire) { awDone := True }
+        when(io.output.w.fire) { wDone := True }
+        when(accepted) {
+            awDone := False
+            wDone := False
+            busy := True
+            last := io.input.w.payload.wlast
+        }
+
+        io.output.aw.valid := issue & ~awDone
+        io.output.aw.payload.awaddr := addr
+        io.output.aw.payload.awprot := 0
+        io.output.w.valid := issue & ~wDone
+        io.output.w.payload.wdata := io.input.w.payload.wdata
+        io.output.w.payload.wstrb := io.input.w.payload.wstrb
+        io.input.w.ready := accepted
+
+        io.output.b.ready := True
+        when(io.output.b.fire) {
+            busy := False
+            addr := addr + config.bytePerBeat
+            when(io.output.b.payload.bresp =/= Axi4.OKAY) {
+                bresp := io.output.b.payload.bresp
+            }
+            when(last) {
+                bValid := True
+            }
+        }
+
+        io.input.b.valid := bValid
+        io.input.b.payload.bid := id
+        io.input.b.payload.bresp := bresp
+        when(io.input.b.fire) {
+            bValid := False
+            active := False
+        }
+    }
+}
+
+/**
+  * Wide AXI4 master to narrow AXI4 slave
+  */
+case class Axi4Downsizer(inConfig: Axi4Config, outConfig: Axi4Config) extends Component {
+    val io = new Bundle {
+        val input = slave(Axi4(inConfig))
+        val output = master(Axi4(outConfig))
+    }
+    noIoPrefix()
+
+    val ratio = inConfig.dataWidth / outConfig.dataWidth
+    assert(ratio >= 2 && isPow2(ratio))
+    assert(inConfig.idWidth == outConfig.idWidth)
+
+    // number of the narrow beats: (len + 1) * ratio - 1
+    def narrowLen(len: UInt): UInt = (len @@ U(ratio - 1, log2Up(ratio) bits)).resize(8 bits)
+
+    val read = new Area {
+        io.output.ar.arbitrationFrom(io.input.ar)
+        io.output.ar.payload.assignSomeByName(io.input.ar.payload)
+        io.output.ar.payload.arlen := narrowLen(io.input.ar.payload.arlen)
+        io.output.ar.payload.arsize := outConfig.fullSize
+
+        // gather the narrow beats into a wide beat
+        val cnt = Reg(UInt(log2Up(ratio) bits)) init 0
+        val buffer = Reg(Vec(Bits(outConfig.DW bits), ratio))
+        val full = cnt === ratio - 1
+
+        io.output.r.ready := ~full | io.input.r.ready
+        when(io.output.r.fire) {
+            cnt := cnt + 1
+            buffer(cnt) := io.output.r.payload.rdata
+        }
+
+        io.input.r.valid := io.output.r.valid & full
+        io.input.r.payload.rdata := io.output.r.payload.rdata ## Cat(buffer.take(ratio - 1))
+        io.input.r.payload.rid := io.output.r.payload.rid
+        io.input.r.payload.rresp := io.output.r.payload.rresp
+        io.input.r.payload.rlast := io.output.r.payload.rlast
+    }
+
+    val write = new Area {
+        io.output.aw.arbitrationFrom(io.input.aw)
+        io.output.aw.payload.assignSomeByName(io.input.aw.payload)
+        io.output.aw.payload.awlen := narrowLen(io.input.aw.payload.awlen)
+        io.output.aw.payload.awsize := outConfig.fullSize
+
+        // split the wide beat into the narrow beats
+        val cnt = Reg(UInt(log2Up(ratio) bits)) init 0
+        val last = cnt === ratio - 1
+
+        io.output.w.valid := io.input.w.valid
+        io.output.w.payload.wdata := io.input.w.payload.wdata.subdivideIn(ratio slices).read(cnt)
+        io.output.w.payload.wstrb := io.input.w.payload.wstrb.subdivideIn(ratio slices).read(cnt)
+        io.output.w.payload.wlast := io.input.w.payload.wlast & last
+        io.input.w.ready := io.output.w.ready & last
+        when(io.output.w.fire) {
+            cnt := cnt + 1
+        }
+
+        io.input.b.arbitrationFrom(io.output.b)
+        io.input.b.payload := io.output.b.payload
+    }
+}
+
+object Axi4BridgeVerilog extends App {
+    Config.spinal.generateVerilog(Axi4ToAxi4Lite(Axi4Config(), Axi4LiteConfig()))
+    Config.spinal.generateVerilog(Axi4Downsizer(Axi4Config(dataWidth = 64), Axi4Config(dataWidth = 32)))
+}
@@ -0,0 +1,81 @@
+/* ------------------------------------------------------------------------------------------------
+ * Copyright (c) 2023. Heqing Huang (feipenghhq@gmail.com)
+ *
+ * Project: NPC
+ * Author: Heqing Huang
+ * Date Created: 10/18/2026
+ *
+ * ------------------------------------------------------------------------------------------------
+ * Axi4 Decoder
+ * ------------------------------------------------------------------------------------------------
+ * The output is selected by the address of the AR/AW request. The selection is kept until the
+ * whole burst completes so a new request is blocked until the previous response comes back.
+ * ------------------------------------------------------------------------------------------------
+ */
+package bus.Axi4
+
+import spinal.core._
+import spinal.lib._
+import config._
+
+case class Axi4Decoder(config: Axi4Config, decoding: Seq[Range]) extends Component {
+    val io = new Bundle {
+        val input = slave(Axi4(config))
+        val output = Vec(master(Axi4(config)), decoding.size)
+    }
+    noIoPrefix()
+
+    val read = new Area {
+        // Decode the AR channel
+        val araddr = io.input.ar.payload.araddr
+        val hits = decoding.map(r => (araddr >= r.start && araddr <= r.end)).asBits
+        val pending = RegNextWhen(True, io.input.ar.fire) clearWhen(io.input.r.fire & io.input.r.payload.rlast) init False
+        val hitsBuffer = RegNextWhen(hits, io.input.ar.fire) init 0
+        for ((output, hit) <- io.output.zip(hits.asBools)) {
+            output.ar.valid := io.input.ar.valid & hit & ~pending
+            output.ar.payload <> io.input.ar.payload
+        }
+        io.input.ar.ready := (io.output.map(_.ar.ready).asBits & hits).orR & ~pending
+
+        // Route back the R channel
+        io.output.zip(hitsBuffer.asBools).foreach(f => f._1.r.ready := io.input.r.ready & f._2)
+        io.input.r.valid := (io.output.map(_.r.valid).asBits & hitsBuffer).orR
+        io.input.r.payload <> MuxOH(hitsBuffer, io.output.map(_.r.payload))
+    }
+
+    val write = new Area {
+        // Decode the AW channel
+        val awaddr = io.input.aw.payload.awaddr
+        val hits = decoding.map(r => (awaddr >= r.start && awaddr <= r.end)).asBits
+        val pending = RegNextWhen(True, io.input.aw.fire) clearWhen(io.input.b.fire) init False
+        val hitsBuffer = RegNextWhen(hits, io.input.aw.fire) init 0
+        for ((output, hit) <- io.output.zip(hits.asBools)) {
+            output.aw.valid := io.input.aw.valid & hit & ~pending
+            output.aw.payload <> io.input.aw.payload
+        }
+        io.input.aw.ready := (io.output.map(_.aw.ready).asBits & hits).orR & ~pending
+
+        // Route the W channel after the AW request is accepted
+        for ((output, hit) <- io.output.zip(hitsBuffer.asBools)) {
+            output.w.valid := io.input.w.valid & hit & pending
+            output.w.payload <> io.input.w.payload
+        }
+        io.input.w.ready := (io.output.map(_.w.ready).asBits & hitsBuffer).orR & pending
+
+        // Route back the B channel
+        io.output.zip(hitsBuffer.asBools).foreach(f => f._1.b.ready := io.input.b.ready & f._2)
+        io.input.b.valid := (io.output.map(_.b.valid).asBits & hitsBuffer).orR
+        io.input.b.payload <> MuxOH(hitsBuffer, io.output.map(_.b.payload))
+    }
+}
+
+object Axi4DecoderVerilog extends App {
+    val config = Axi4Config()
+    val decoding = Seq(
+        Range(0x0, 0x0FFFFFFF),
+        Range(0x10000000, 0x1FFFFFFF),
+        Range(0x20000000, 0x2FFFFFFF),
+        Range(0x30000000, 0x3FFFFFFF),
+    )
+    Config.spinal.generateVerilog(Axi4Decoder(config, decoding))
+}
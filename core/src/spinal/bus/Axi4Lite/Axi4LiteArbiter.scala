@@ -49,6 +49,7 @@ case class Axi4LiteArbiter(config: Axi4LiteConfig, count: Int, parallelRW: Boole
     val io = new Bundle {
         val input = Vec(slave(Axi4Lite(config)), count)
         val output = master(Axi4Lite(config))
+        val stall = out port Bool()     // a request is blocked by the arbitration. For performance counter
     }
     noIoPrefix()
 
@@ -129,4 +130,9 @@ case class Axi4LiteArbiter(config: Axi4LiteConfig, count: Int, parallelRW: Boole
     io.output.b.ready := (b.map(_.ready).asBits & awwGranted.asBits).orR
     b.zipWithIndex.foreach(f => f._1.valid := io.output.b.valid & awwGranted(f._2))
     b.foreach(_.payload := io.output.b.payload)
+
+    // A request is blocked when it is not granted or the previous transaction has not completed
+    val arStall = ar.zipWithIndex.map(f => f._1.valid & ~(arGrant(f._2) & ~arPending)).asBits.orR
+    val awStall = aw.zipWithIndex.map(f => f._1.valid & ~(awwGrant(f._2) & ~awwPending)).asBits.orR
+    io.stall := arStall | awStall
 }
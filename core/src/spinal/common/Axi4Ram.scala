@@ -0,0 +1,264 @@
+/* ------------------------------------------------------------------------------------------------
+ * Copyright (c) 2023. Heqing Huang (feipenghhq@gmail.com)
+ *
+ * Project: NPC
+ * Author: Heqing Huang
+ * Date Created: 10/18/2026
+ *
+ * ------------------------------------------------------------------------------------------------
+ * Axi4Ram: RAM access by Axi4 Bus with burst support
+ * ------------------------------------------------------------------------------------------------
+ * 10/18/2026: Pipelined the read and write path to model the latency of a real memory
+ * The whole burst is read or written with a single access to the RAM:
+ *  - Read: the AR requests are queued so several reads can be outstanding. A request accesses the RAM
+ *          when it has waited for the read latency and the previous burst is returning its last beat.
+ *          The data is returned beat by beat so back-to-back bursts are returned without a gap.
+ *  - Write: the W beats are collected into a line buffer and pushed into the write queue when the last
+ *           beat arrives. The B response is returned when the burst is queued (posted write) and the
+ *           write queue drains one burst per cycle.
+ * A read does not access the RAM before the earlier queued writes so it always sees the posted writes.
+ * The latency and queue depth are set by RamConfig. Only INCR burst of the full data width is supported
+ * and the burst length is limited by maxBurst. A longer burst does not access the RAM and is responded
+ * with SLVERR.
+ * ------------------------------------------------------------------------------------------------
+ */
+
+package common
+
+import spinal.core._
+import spinal.lib._
+import config._
+import _root_.bus.Axi4._
+
+/**
+  * Axi4 RAM
+  *
+  * @param config   Core Config
+  * @param ramType  Ram type
+  */
+case class Axi4Ram(config: RiscCoreConfig, ramType: RamType) extends Component {
+
+    val isDPI = ramType == RamType.DPI
+    val axi4Config = config.axi4Config
+    val ramConfig = config.ram
+    val maxBurst = ramConfig.maxBurst
+    val lineWidth = maxBurst * axi4Config.dataWidth
+
+    val io = new Bundle {
+        val axi4 = slave(Axi4(axi4Config))
+        // tracing info for DPI
+        val pc     = isDPI generate in port config.xlenUInt
+        val ifetch = isDPI generate in port Bool()
+    }
+
+    // the burst is longer than the line buffer
+    def tooLong(len: UInt): Bool = if (maxBurst > 255) False else len >= maxBurst
+
+    // free running cycle counter to time the read latency
+    val cycle = Reg(UInt(16 bits)) init 0
+    cycle := cycle + 1
+
+    // --------------------------------------------
+    // Write
+    // --------------------------------------------
+    case class WriteCmd() extends Bundle {
+        val addr = UInt(axi4Config.AW bits)
+        val len = UInt(8 bits)
+        val data = Bits(lineWidth bits)
+        val strb = Bits(lineWidth / 8 bits)
+        val pc = config.xlenUInt
+    }
+
+    case class WriteRsp() extends Bundle {
+        val id = UInt(axi4Config.IW bits)
+        val resp = Bits(2 bits)
+    }
+
+    val write = new Area {
+        val active = Reg(Bool()) init False     // collecting the W beats
+        val err = Reg(Bool())                   // the burst is too long. The W beats are dropped
+        val id = Reg(UInt(axi4Config.IW bits))
+        val addr = Reg(UInt(axi4Config.AW bits))
+        val len = Reg(UInt(8 bits))
+        val cnt = Reg(UInt(log2Up(maxBurst) bits))
+        val data = Reg(Vec(Bits(axi4Config.DW bits), maxBurst))
+        val strb = Reg(Vec(Bits(axi4Config.DW / 8 bits), maxBurst))
+
+        // push the burst into the write queue at the cycle after the last beat is collected
+        val done = RegNext(io.axi4.w.fire & io.axi4.w.payload.wlast) init False
+        val queue = StreamFifo(WriteCmd(), ramConfig.writeQueue)
+        val bQueue = StreamFifo(WriteRsp(), ramConfig.writeQueue)
+
+        queue.io.push.valid := done & ~err
+        queue.io.push.payload.addr := addr
+        queue.io.push.payload.len := len
+        queue.io.push.payload.data := data.asBits
+        queue.io.push.payload.strb := strb.asBits
+        queue.io.push.payload.pc := (if (isDPI) io.pc else U(0, config.xlen bits))
+        queue.io.pop.ready := True
+
+        bQueue.io.push.valid := done
+        bQueue.io.push.payload.id := id
+        bQueue.io.push.payload.resp := Mux(err, Axi4.SLVERR, Axi4.OKAY)
+
+        // only one burst is collected at a time. Make sure it has a slot in both queues
+        io.axi4.aw.ready := ~active & ~done & queue.io.push.ready & bQueue.io.push.ready
+        when(io.axi4.aw.fire) {
+            active := True
+            err := tooLong(io.axi4.aw.payload.awlen)
+            id := io.axi4.aw.payload.awid
+            addr := io.axi4.aw.payload.awaddr
+            len := io.axi4.aw.payload.awlen
+            cnt := 0
+            strb.foreach(_ := 0)
+        }
+
+        io.axi4.w.ready := active
+        when(io.axi4.w.fire) {
+            cnt := cnt + 1
+            data(cnt) := io.axi4.w.payload.wdata
+            strb(cnt) := io.axi4.w.payload.wstrb
+            when(io.axi4.w.payload.wlast) {
+                active := False
+            }
+        }
+
+        val enable = queue.io.pop.fire
+    }
+
+    // --------------------------------------------
+    // Read
+    // --------------------------------------------
+    case class ReadCmd() extends Bundle {
+        val addr = UInt(axi4Config.AW bits)
+        val id = UInt(axi4Config.IW bits)
+        val len = UInt(8 bits)
+        val due = UInt(16 bits)         // the cycle when the request can access the RAM
+        val pc = config.xlenUInt
+        val ifetch = Bool()
+        val err = Bool()                // the burst is too long. The RAM is not accessed
+    }
+
+    val read = new Area {
+        // request queue. The tracing info is captured with the request
+        val cmd = ReadCmd()
+        cmd.addr := io.axi4.ar.payload.araddr
+        cmd.id := io.axi4.ar.payload.arid
+        cmd.len := io.axi4.ar.payload.arlen
+        cmd.due := cycle + (ramConfig.readLatency - 1)
+        cmd.err := tooLong(io.axi4.ar.payload.arlen)
+        if (isDPI) {
+            cmd.pc := io.pc
+            cmd.ifetch := io.ifetch
+        } else {
+            cmd.pc := 0
+            cmd.ifetch := False
+        }
+        val queue = io.axi4.ar.translateWith(cmd).queueLowLatency(ramConfig.readQueue)
+
+        val active = Reg(Bool()) init False     // a burst is being returned
+        val err = Reg(Bool())
+        val id = Reg(UInt(axi4Config.IW bits))
+        val len = Reg(UInt(8 bits))
+        val cnt = Reg(UInt(8 bits))
+        val last = cnt === len
+
+        // issue the next request when
+        // 1. it has waited for the read latency
+        // 2. the last beat of the current burst is returned
+        // 3. the earlier writes are written to the RAM (the write drained at this cycle goes first)
+        val ready = (cycle - queue.payload.due).msb === False
+        val idle = ~active | io.axi4.r.fire & last
+        queue.ready := ready & idle & (write.queue.io.occupancy <= 1)
+        val enable = queue.fire
+
+        when(io.axi4.r.fire & last) {
+            active := False
+        }
+        when(enable) {
+            active := True
+            err := queue.payload.err
+            id := queue.payload.id
+            len := queue.payload.len
+            cnt := 0
+        } elsewhen(io.axi4.r.fire) {
+            cnt := cnt + 1
+        }
+    }
+
+    // --------------------------------------------
+    //  Access the RAM
+    // --------------------------------------------
+
+    val rdata = Bits(lineWidth bits)
+
+    // RamType: DPI
+    if (isDPI) {
+        val ram = RamBurstDpi(config, maxBurst)
+        ram.io.ifetch := read.queue.payload.ifetch
+        ram.io.rpc    := read.queue.payload.pc
+        ram.io.wpc    := write.queue.io.pop.payload.pc
+
+        ram.io.rvalid := read.enable & ~read.queue.payload.err
+        ram.io.raddr  := read.queue.payload.addr
+        ram.io.rlen   := read.queue.payload.len
+        rdata         := ram.io.rdata
+
+        ram.io.wvalid := write.enable
+        ram.io.waddr  := write.queue.io.pop.payload.addr
+        ram.io.wlen   := write.queue.io.pop.payload.len
+        ram.io.wdata  := write.queue.io.pop.payload.data
+        ram.io.wstrb  := write.queue.io.pop.payload.strb
+    }
+
+    // --------------------------------------------
+    //  Response channel
+    // --------------------------------------------
+    io.axi4.r.valid := read.active
+    io.axi4.r.payload.rdata := rdata.subdivideIn(maxBurst slices).read(read.cnt.resized)
+    io.axi4.r.payload.rid := read.id
+    io.axi4.r.payload.rresp := Mux(read.err, Axi4.SLVERR, Axi4.OKAY)
+    io.axi4.r.payload.rlast := read.last
+
+    io.axi4.b.arbitrationFrom(write.bQueue.io.pop)
+    io.axi4.b.payload.bid := write.bQueue.io.pop.payload.id
+    io.axi4.b.payload.bresp := write.bQueue.io.pop.payload.resp
+}
+
+
+/**
+  * Black box for verilog module RamBurstDpi
+  *
+  * @param config
+  * @param maxBurst
+  */
+case class RamBurstDpi (config: RiscCoreConfig, maxBurst: Int) extends BlackBox {
+
+  val generic = new Generic {
+    val XLEN = config.xlen
+    val DATA_WIDTH = config.axi4Config.dataWidth
+    val MAX_BURST = maxBurst
+  }
+
+  val lineWidth = maxBurst * config.axi4Config.dataWidth
+
+  val io = new Bundle {
+    val clk    = in port Bool()
+    val rst_b  = in port Bool()
+    val rvalid = in port Bool()
+    val raddr  = in port config.xlenUInt
+    val rlen   = in port UInt(8 bits)
+    val rdata  = out port Bits(lineWidth bits)
+    val wvalid = in port Bool()
+    val waddr  = in port config.xlenUInt
+    val wlen   = in port UInt(8 bits)
+    val wdata  = in port Bits(lineWidth bits)
+    val wstrb  = in port Bits(lineWidth / 8 bits)
+    val ifetch = in port Bool()
+    val rpc    = in port config.xlenUInt
+    val wpc    = in port config.xlenUInt
+  }
+
+  noIoPrefix()
+  mapClockDomain(clock = io.clk, reset = io.rst_b, resetActiveLevel = LOW)
+}
@@ -7,6 +7,9 @@
  * ------------------------------------------------------------------------------------------------
  * RrArbiter: Round Robin Arbiter
  * ------------------------------------------------------------------------------------------------
+ * 10/18/2026: Added weighted round robin. A requester with weight N can be granted up to N times in
+ * a row before the priority moves to the next requester.
+ * ------------------------------------------------------------------------------------------------
  */
 
 package common
@@ -17,10 +20,11 @@ import spinal.lib._
 /**
   * A round robin arbiter
   *
-  * @param width number of requester
+  * @param width   number of requester
+  * @param weights weight of each requester. Empty for the same weight (plain round robin)
   */
 
-case class RrArbiter(width: Int) extends Component {
+case class RrArbiter(width: Int, weights: Seq[Int] = Seq()) extends Component {
     val io = new Bundle {
         val req = in port Bits(width bit)              // request
         val enable = in port Bool                      // enable the arbiter
@@ -30,12 +34,29 @@ case class RrArbiter(width: Int) extends Component {
     }
     noIoPrefix()
 
+    assert(weights.isEmpty || weights.size == width && weights.forall(_ >= 1))
+
     // Record the previous grant result for the next arbitration
     io.prevGrant := RegNextWhen(io.grant, io.enable) init 1
+
+    // Remaining grants of the previous granted requester before the priority moves on
+    val keep = Bool()
+    if (weights.isEmpty || weights.forall(_ == 1)) {
+        keep := False
+    } else {
+        val credit = Reg(UInt(log2Up(weights.max) bits)) init 0
+        val weightTable = Vec(weights.map(w => U(w - 1, credit.getWidth bits)))
+        keep := credit =/= 0
+        when(io.enable) {
+            credit := Mux(keep & io.grant === io.prevGrant, credit - 1, weightTable(io.grantId))
+        }
+    }
+
     // Use the double bit mask technic for arbitration and shift the last grant left by 1
-    // to make the next request as highest priority
+    // to make the next request as highest priority. The last grant keeps the highest
+    // priority while it has credit left.
     val doubleReq = (io.req ## io.req).asUInt
-    val base = io.prevGrant.rotateLeft(1)
+    val base = Mux(keep, io.prevGrant, io.prevGrant.rotateLeft(1))
     val doubleGrant = doubleReq & ~(doubleReq - base)
     io.grant   := doubleGrant(width - 1 downto 0) | doubleGrant(width * 2 -1 downto width)
     io.grantId := OHToUInt(io.grant)
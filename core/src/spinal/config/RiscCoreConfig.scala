@@ -14,15 +14,98 @@ package config
 
 import spinal.core._
 import _root_.bus.Axi4Lite._
+import _root_.bus.Axi4._
+
+/**
+  * Cache configuration
+  *
+  * @param size     cache size in bytes
+  * @param lineSize cache line size in bytes
+  * @param ways     associativity
+  * @param uncached uncached regions (base, size). Used by the data cache for MMIO.
+  *                 The size should be power of 2 and the base should be aligned to the size.
+  */
+case class CacheConfig(
+    size: Int = 4096,
+    lineSize: Int = 16,
+    ways: Int = 2,
+    uncached: Seq[(Long, Long)] = Seq()
+) {
+    def sets = size / lineSize / ways
+    def indexWidth = log2Up(sets)
+    def offsetWidth = log2Up(lineSize)
+
+    def isUncached(addr: UInt): Bool = {
+        uncached.map { case (base, size) =>
+            (addr & ~U(size - 1, addr.getWidth bits)) === U(base, addr.getWidth bits)
+        }.foldLeft(False)(_ | _)
+    }
+
+    assert(isPow2(size) && isPow2(lineSize) && isPow2(ways))
+    assert(sets >= 2)
+    uncached.foreach { case (base, size) => assert(isPow2(size) && base % size == 0) }
+}
+
+/**
+  * Define different branch predictor type
+  */
+sealed abstract class BpuType
+object BpuType {
+    case object STATIC extends BpuType     // backward taken, forward not taken (BTFN) on the fetched instruction
+    case object DYNAMIC extends BpuType    // BTB + BHT + return address stack (RAS) at the fetch request
+}
+
+/**
+  * Branch predictor configuration. Used by the pipelined core only
+  *
+  * @param bpuType  predictor type
+  * @param bhtSize  number of the 2 bits counters in the branch history table
+  * @param btbSize  number of the branch target buffer entries (direct mapped)
+  * @param rasDepth depth of the return address stack
+  */
+case class BpuConfig(
+    bpuType: BpuType = BpuType.DYNAMIC,
+    bhtSize: Int = 128,
+    btbSize: Int = 16,
+    rasDepth: Int = 4
+) {
+    def bhtIndexWidth = log2Up(bhtSize)
+    def btbIndexWidth = log2Up(btbSize)
+
+    assert(isPow2(bhtSize) && isPow2(btbSize) && isPow2(rasDepth) && rasDepth >= 2)
+}
+
+/**
+  * Memory model configuration of the simulation RAM
+  *
+  * @param readLatency cycles from the AR handshake to the first R beat. Should be at least 1
+  * @param readQueue   number of the outstanding read requests
+  * @param writeQueue  number of the buffered write bursts. The B response is returned once the burst is buffered
+  * @param maxBurst    maximum burst length (beats)
+  */
+case class RamConfig(
+    readLatency: Int = 1,
+    readQueue: Int = 4,
+    writeQueue: Int = 2,
+    maxBurst: Int = 16
+) {
+    assert(readLatency >= 1 && readQueue >= 1 && writeQueue >= 1)
+}
 
 case class RiscCoreConfig(
     // ISA related parameter
     xlen: Int = 32,                     // Cpu data width
     pcRstVector: BigInt = 0x80000000L,  // Need to add L here: https://github.com/SpinalHDL/SpinalHDL/issues/1420
+                                        // Other tops drive the reset vector through the rstVector port
     nreg: Int = 32,                     // Number of register. 16 or 32
+    rvc: Boolean = false,               // RV32C compressed instruction extension
 
     // Other parameter
     separateSram: Boolean = false,      // use two separate SRAM for instruction and data
+    icache: Option[CacheConfig] = None, // instruction cache. None for no instruction cache
+    dcache: Option[CacheConfig] = None, // data cache. None for no data cache
+    bpu: Option[BpuConfig] = None,      // branch predictor. None for predict not taken
+    ram: RamConfig = RamConfig(),       // simulation RAM model in the SoC
     axi4LiteConfig: Axi4LiteConfig,     // AXI4 Lite bus configuration
 ) {
     def regidWidth = log2Up(nreg)
@@ -33,6 +116,9 @@ case class RiscCoreConfig(
     def xlenSInt = SInt(xlen bit)
     def regidUInt = UInt(regidWidth bit)
 
+    // AXI4 bus of the core. Same address and data width as the AXI4 Lite bus
+    def axi4Config = Axi4Config(addrWidth = axi4LiteConfig.addrWidth, dataWidth = axi4LiteConfig.dataWidth)
+
     assert(xlen == 32)
     assert(nreg == 32)
 }
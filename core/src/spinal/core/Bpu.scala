@@ -0,0 +1,122 @@
+/* ------------------------------------------------------------------------------------------------
+ * Copyright (c) 2023. Heqing Huang (feipenghhq@gmail.com)
+ *
+ * Project: NPC
+ * Author: Heqing Huang
+ * Date Created: 10/18/2026
+ *
+ * ------------------------------------------------------------------------------------------------
+ * Bpu: Dynamic Branch Prediction Unit
+ * ------------------------------------------------------------------------------------------------
+ * The prediction is made on the PC of the fetch request:
+ *  - BTB: direct mapped branch target buffer. Holds the target and the kind of the taken
+ *    branch/jump (branch, jump, call, return).
+ *  - BHT: 2 bits saturating counters indexed by the PC. Used for the conditional branch only.
+ *  - RAS: return address stack. Pushed by a predicted call and popped by a predicted return.
+ *    The RAS is updated speculatively and is not repaired on misprediction.
+ *
+ * The BTB and BHT are updated when the branch/jump is resolved in EX stage.
+ * ------------------------------------------------------------------------------------------------
+ */
+
+package core
+
+import spinal.core._
+import spinal.lib._
+import config._
+
+/** Branch/jump result from EX stage to update the predictor */
+case class BpuUpdate(config: RiscCoreConfig) extends Bundle {
+    val pc = config.xlenUInt
+    val target = config.xlenUInt
+    val taken = Bool()
+    val branch = Bool()     // conditional branch
+    val jump = Bool()       // jal/jalr. Neither branch nor jump removes the BTB entry
+    val call = Bool()       // jal/jalr with rd = x1/x5
+    val ret = Bool()        // jalr with rs1 = x1/x5 and rd = x0
+}
+
+object BtbKind {
+    def BRANCH = B"00"
+    def JUMP   = B"01"
+    def CALL   = B"10"
+    def RET    = B"11"
+}
+
+case class Bpu(config: RiscCoreConfig, bpuConfig: BpuConfig) extends Component {
+    val io = new Bundle {
+        val pc = in port config.xlenUInt            // PC of the fetch request
+        val fire = in port Bool()                   // the fetch request is issued. Update the RAS
+        val taken = out port Bool()                 // predicted taken
+        val target = out port config.xlenUInt       // predicted target
+        val update = slave Flow(BpuUpdate(config))  // update from EX stage
+    }
+    noIoPrefix()
+
+    val btbTagWidth = config.xlen - 2 - bpuConfig.btbIndexWidth
+    def btbIndex(pc: UInt) = pc(2, bpuConfig.btbIndexWidth bits)
+    def btbTag(pc: UInt) = pc(config.xlen - 1 downto 2 + bpuConfig.btbIndexWidth)
+    def bhtIndex(pc: UInt) = pc(2, bpuConfig.bhtIndexWidth bits)
+
+    // -----------------------------
+    // Storage
+    // -----------------------------
+    val btbValid = Vec.fill(bpuConfig.btbSize)(Reg(Bool()) init False)
+    val btbTagRam = Mem(UInt(btbTagWidth bits), bpuConfig.btbSize)
+    val btbTargetRam = Mem(config.xlenUInt, bpuConfig.btbSize)
+    val btbKindRam = Mem(Bits(2 bits), bpuConfig.btbSize)
+    val bht = Vec.fill(bpuConfig.bhtSize)(Reg(UInt(2 bits)) init 1)   // weakly not taken
+    val ras = Vec(Reg(config.xlenUInt), bpuConfig.rasDepth)
+    val rasPtr = Reg(UInt(log2Up(bpuConfig.rasDepth) bits)) init 0     // next push position
+    val rasTop = ras(rasPtr - 1)
+
+    // -----------------------------
+    // Prediction
+    // -----------------------------
+    val index = btbIndex(io.pc)
+    val hit = btbValid(index) & btbTagRam.readAsync(index) === btbTag(io.pc)
+    val kind = btbKindRam.readAsync(index)
+    val counterTaken = bht(bhtIndex(io.pc)).msb
+
+    io.taken := hit & (kind =/= BtbKind.BRANCH | counterTaken)
+    io.target := Mux(kind === BtbKind.RET, rasTop, btbTargetRam.readAsync(index))
+
+    when(io.fire & io.taken) {
+        when(kind === BtbKind.CALL) {
+            ras(rasPtr) := io.pc + 4
+            rasPtr := rasPtr + 1
+        } elsewhen(kind === BtbKind.RET) {
+            rasPtr := rasPtr - 1
+        }
+    }
+
+    // -----------------------------
+    // Update
+    // -----------------------------
+    val update = io.update.payload
+    val updateIndex = btbIndex(update.pc)
+    val updateKind = Mux(update.branch, BtbKind.BRANCH,
+                     Mux(update.ret,    BtbKind.RET,
+                     Mux(update.call,   BtbKind.CALL,
+                                        BtbKind.JUMP)))
+    val btbWrite = io.update.valid & update.taken
+
+    btbTagRam.write(updateIndex, btbTag(update.pc), enable = btbWrite)
+    btbTargetRam.write(updateIndex, update.target, enable = btbWrite)
+    btbKindRam.write(updateIndex, updateKind, enable = btbWrite)
+
+    when(btbWrite) {
+        btbValid(updateIndex) := True
+    } elsewhen(io.update.valid & ~update.branch & ~update.jump) {
+        btbValid(updateIndex) := False
+    }
+
+    val counter = bht(bhtIndex(update.pc))
+    when(io.update.valid & update.branch) {
+        when(update.taken & counter =/= 3) {
+            counter := counter + 1
+        } elsewhen(~update.taken & counter =/= 0) {
+            counter := counter - 1
+        }
+    }
+}
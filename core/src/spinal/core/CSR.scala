@@ -14,6 +14,7 @@ package core
 
 import spinal.core._
 import spinal.lib._
+import spinal.core.Verilator._
 import config._
 import scala.collection.mutable.ArrayBuffer
 
@@ -27,6 +28,23 @@ case class CsrRdPort(config: RiscCoreConfig) extends Bundle {
     val mepc = out port config.xlenBits
 }
 
+/** Events counted by the performance counters. Each event is asserted for one cycle per count */
+case class PerfEvent() extends Bundle {
+    val instret = Bool()        // instruction retired
+    val ifuWait = Bool()        // IFU is waiting for the instruction from ibus
+    val lsuLoadWait = Bool()    // LSU is waiting for the load data
+    val lsuStoreWait = Bool()   // LSU is waiting for the store response
+    val mulDivBusy = Bool()     // MulDiv is busy calculating
+    val busStall = Bool()       // bus request is blocked by the bus arbiter
+    val icacheHit = Bool()      // instruction cache hit
+    val icacheMiss = Bool()     // instruction cache miss
+    val dcacheHit = Bool()      // data cache hit
+    val dcacheMiss = Bool()     // data cache miss
+    val dcacheWb = Bool()       // data cache dirty line write back
+    val branch = Bool()         // branch/jump instruction executed
+    val mispredict = Bool()     // next PC is mispredicted and the fetch is redirected
+}
+
 case class CSR(config: RiscCoreConfig) extends Component {
     val io = new Bundle {
         val csrCtrl = in port CsrCtrl(config)
@@ -35,6 +53,7 @@ case class CSR(config: RiscCoreConfig) extends Component {
         val trap = in port Bool()
         val csrRdPort = CsrRdPort(config)
         val csrWrPort = CsrWrPort(config)
+        val perfEvent = in port PerfEvent()
     }
     noIoPrefix()
 
@@ -111,6 +130,33 @@ case class CSR(config: RiscCoreConfig) extends Component {
 
     }
 
+    /**
+      * Function to add a 64 bits counter
+      * The low 32 bits is mapped to csr at addr and the high 32 bits is mapped to csr at addr + 0x80.
+      * The counter is public so the testbench can read it directly.
+      *
+      * @param csrName csr name. Example: mcycle. The high part is named as mcycleh
+      * @param addr    csr address of the low part
+      * @param event   the counter increments by 1 when event is asserted
+      */
+    def addCounter(csrName: String, addr: Int, event: Bool): UInt = {
+        val counter = Reg(UInt(64 bits)) init 0
+        counter.setName(csrName + "Counter")
+        counter.addAttribute(public)
+        val low = CsrReg(csrName, addr)
+        val high = CsrReg(csrName + "h", addr + 0x80)
+        low.reg := counter(31 downto 0).asBits
+        high.reg := counter(63 downto 32).asBits
+        when(low.write) {
+            counter(31 downto 0) := wdata.asUInt
+        } elsewhen(high.write) {
+            counter(63 downto 32) := wdata.asUInt
+        } elsewhen(event) {
+            counter := counter + 1
+        }
+        counter
+    }
+
     // ---------------------------------------------------
     // Add csr register
     // ---------------------------------------------------
@@ -127,6 +173,23 @@ case class CSR(config: RiscCoreConfig) extends Component {
     val mcause = CsrReg("mcause", 0x342)
     mcause.addField("interrupt",     (xlen-1 downto xlen-1), 0, wr=trap, wrPort=wrPort.mcause(xlen-1).asBits)
     mcause.addField("exceptionCode", (xlen-2 downto 0),      0, wr=trap, wrPort=wrPort.mcause(xlen-2 downto 0))
+
+    // performance counters
+    val perf = io.perfEvent
+    val mcycle        = addCounter("mcycle",       0xb00, True)
+    val minstret      = addCounter("minstret",     0xb02, perf.instret)
+    val mhpmcounter3  = addCounter("mhpmcounter3", 0xb03, perf.ifuWait)
+    val mhpmcounter4  = addCounter("mhpmcounter4", 0xb04, perf.lsuLoadWait)
+    val mhpmcounter5  = addCounter("mhpmcounter5", 0xb05, perf.lsuStoreWait)
+    val mhpmcounter6  = addCounter("mhpmcounter6", 0xb06, perf.mulDivBusy)
+    val mhpmcounter7  = addCounter("mhpmcounter7", 0xb07, perf.busStall)
+    val mhpmcounter8  = addCounter("mhpmcounter8", 0xb08, perf.icacheHit)
+    val mhpmcounter9  = addCounter("mhpmcounter9", 0xb09, perf.icacheMiss)
+    val mhpmcounter10 = addCounter("mhpmcounter10", 0xb0a, perf.dcacheHit)
+    val mhpmcounter11 = addCounter("mhpmcounter11", 0xb0b, perf.dcacheMiss)
+    val mhpmcounter12 = addCounter("mhpmcounter12", 0xb0c, perf.dcacheWb)
+    val mhpmcounter13 = addCounter("mhpmcounter13", 0xb0d, perf.branch)
+    val mhpmcounter14 = addCounter("mhpmcounter14", 0xb0e, perf.mispredict)
     // ---------------------------------------------------
 
     // read data mux
@@ -16,27 +16,67 @@ import spinal.core._
 import spinal.lib._
 import config._
 import _root_.bus.Axi4Lite._
+import _root_.bus.Axi4._
 
 case class CoreN(config: RiscCoreConfig) extends Component {
     val io = new Bundle {
-        val ibus = master(Axi4Lite(config.axi4LiteConfig))
-        val dbus = master(Axi4Lite(config.axi4LiteConfig))
+        val ibus = master(Axi4(config.axi4Config))
+        val dbus = master(Axi4(config.axi4Config))
+        val busStall = in port Bool()   // bus request is blocked by the bus arbiter. For performance counter
+        val rstVector = in port config.xlenUInt // pc loaded during reset
     }
     noIoPrefix()
 
     val uIFU = IFU(config)
+    uIFU.io.rstVector := io.rstVector
     val uIDU = IDU(config)
     val uEXU = EXU(config)
 
     uIFU.io.branchCtrl <> uEXU.io.branchCtrl
-    uIFU.io.ibus <> io.ibus
     uIFU.io.trapCtrl <> uEXU.io.trapCtrl
+    uIFU.io.flush := uEXU.io.fencei
 
     uIDU.io.ifuData <> uIFU.io.ifuData
     uIDU.io.rdWrCtrl <> uEXU.io.rdWrCtrl
 
     uEXU.io.iduData <> uIDU.io.iduData
-    uEXU.io.dbus <> io.dbus
+    uEXU.io.fetchWait <> uIFU.io.fetchWait
+    uEXU.io.busStall <> io.busStall
+
+    // Instruction cache
+    if (config.icache.isDefined) {
+        val uICache = ICache(config, config.icache.get)
+        uICache.io.cpu <> uIFU.io.ibus
+        uICache.io.mem <> io.ibus
+        uICache.io.invalidate := uEXU.io.fencei
+        uEXU.io.icacheHit := uICache.io.hit
+        uEXU.io.icacheMiss := uICache.io.miss
+    } else {
+        val uIBusBridge = Axi4LiteToAxi4(config.axi4LiteConfig, config.axi4Config)
+        uIBusBridge.io.input <> uIFU.io.ibus
+        uIBusBridge.io.output <> io.ibus
+        uEXU.io.icacheHit := False
+        uEXU.io.icacheMiss := False
+    }
+
+    // Data cache
+    if (config.dcache.isDefined) {
+        val uDCache = DCache(config, config.dcache.get)
+        uDCache.io.cpu <> uEXU.io.dbus
+        uDCache.io.mem <> io.dbus
+        uDCache.io.flush <> uEXU.io.dcacheFlush
+        uEXU.io.dcacheHit := uDCache.io.hit
+        uEXU.io.dcacheMiss := uDCache.io.miss
+        uEXU.io.dcacheWb := uDCache.io.writeback
+    } else {
+        val uDBusBridge = Axi4LiteToAxi4(config.axi4LiteConfig, config.axi4Config)
+        uDBusBridge.io.input <> uEXU.io.dbus
+        uDBusBridge.io.output <> io.dbus
+        uEXU.io.dcacheFlush.ready := True
+        uEXU.io.dcacheHit := False
+        uEXU.io.dcacheMiss := False
+        uEXU.io.dcacheWb := False
+    }
 
     val iduData = uIDU.io.iduData.payload
 }
@@ -0,0 +1,367 @@
+/* ------------------------------------------------------------------------------------------------
+ * Copyright (c) 2023. Heqing Huang (feipenghhq@gmail.com)
+ *
+ * Project: NPC
+ * Author: Heqing Huang
+ * Date Created: 10/18/2026
+ *
+ * ------------------------------------------------------------------------------------------------
+ * CoreP: Risc V Core 5 stage Pipeline
+ * ------------------------------------------------------------------------------------------------
+ * IF:  Fetch the instruction (IfuP)
+ * ID:  Decode the instruction and read the register file
+ * EX:  ALU, MulDiv, branch (BEU), CSR and trap (TrapCtrl)
+ * MEM: Load and store (LSU)
+ * WB:  Write back to the register file. The instruction is committed in this stage.
+ *
+ * Hazard handling:
+ *  - Data hazard: The result in MEM and WB stage is forwarded to EX stage. The result in WB stage is
+ *    also bypassed to ID stage since it is written to the register file at the end of the cycle.
+ *    The forwarded operands are kept in the ID/EX register while EX stage is stalled.
+ *    For load-use hazard, the instruction in ID stage is stalled for one cycle.
+ *  - Control hazard: The branch/jump/trap is resolved in EX stage. The fetch is predicted by IfuP (not
+ *    taken without branch predictor). When the next PC is different from the predicted one, the fetch
+ *    is redirected and the instructions in IF and ID stage are flushed.
+ *    fence.i writes back the data cache, invalidates the instruction cache and redirects the fetch to
+ *    the next instruction.
+ *  - Structural hazard: A stage stalls all the previous stages when it can't complete in one cycle.
+ * ------------------------------------------------------------------------------------------------
+ */
+
+package core
+
+import spinal.core._
+import spinal.lib._
+import spinal.core.Verilator._
+import config._
+import _root_.bus.Axi4Lite._
+import _root_.bus.Axi4._
+
+/** Pipeline register between EX and MEM stage */
+case class ExMemBundle(config: RiscCoreConfig) extends Bundle {
+    val cpuCtrl = CpuCtrl(config)
+    val pc = config.xlenUInt
+    val nextPc = config.xlenUInt        // PC of the next instruction in program order
+    val instruction = config.xlenBits
+    val result = config.xlenBits        // rd write data for non-load instruction
+    val addr = config.xlenUInt          // memory address
+    val wdata = config.xlenBits         // store data
+}
+
+/** Pipeline register between MEM and WB stage */
+case class MemWbBundle(config: RiscCoreConfig) extends Bundle {
+    val rdWrite = Bool()
+    val rdAddr = config.regidUInt
+    val data = config.xlenBits
+    val pc = config.xlenUInt
+    val nextPc = config.xlenUInt
+    val instruction = config.xlenBits
+    val ebreak = Bool()
+    val ecall = Bool()
+}
+
+case class CoreP(config: RiscCoreConfig) extends Component {
+    val io = new Bundle {
+        val ibus = master(Axi4(config.axi4Config))
+        val dbus = master(Axi4(config.axi4Config))
+        val busStall = in port Bool()   // bus request is blocked by the bus arbiter. For performance counter
+        val rstVector = in port config.xlenUInt // pc loaded during reset
+    }
+    noIoPrefix()
+    assert(!config.rvc, "RV32C is only supported by CoreN")
+
+    // ----------------------------
+    // Pipeline control
+    // ----------------------------
+    val stallMem = Bool()                   // MEM stage is waiting for the memory access
+    val stallEx  = Bool()                   // EX stage can't move forward
+    val stallId  = Bool()                   // ID stage can't move forward
+    val redirect = Flow(config.xlenUInt)    // branch/jump/trap is taken in EX stage
+
+    // ----------------------------
+    // Pipeline register
+    // ----------------------------
+    val exValid  = Reg(Bool()) init False
+    val ex       = Reg(IduBundle(config))
+    val exInst   = Reg(config.xlenBits)
+    val exPredPc = Reg(config.xlenUInt)
+    val memValid = Reg(Bool()) init False
+    val mem      = Reg(ExMemBundle(config))
+    val wbValid  = Reg(Bool()) init False
+    val wb       = Reg(MemWbBundle(config))
+
+    // ----------------------------
+    // IF stage
+    // ----------------------------
+    val uIFU = IfuP(config)
+    uIFU.io.rstVector := io.rstVector
+    uIFU.io.redirect := redirect
+    val fencei = Bool()
+
+    // Instruction cache
+    val icacheHit = Bool()
+    val icacheMiss = Bool()
+    if (config.icache.isDefined) {
+        val uICache = ICache(config, config.icache.get)
+        uICache.io.cpu <> uIFU.io.ibus
+        uICache.io.mem <> io.ibus
+        uICache.io.invalidate := fencei
+        icacheHit := uICache.io.hit
+        icacheMiss := uICache.io.miss
+    } else {
+        val uIBusBridge = Axi4LiteToAxi4(config.axi4LiteConfig, config.axi4Config)
+        uIBusBridge.io.input <> uIFU.io.ibus
+        uIBusBridge.io.output <> io.ibus
+        icacheHit := False
+        icacheMiss := False
+    }
+
+    val ifuData = uIFU.io.ifuData
+
+    // ----------------------------
+    // ID stage
+    // ----------------------------
+    val uDec = Decoder(config)
+    uDec.io.ifuData.assignSomeByName(ifuData.payload)
+    val idCtrl = uDec.io.cpuCtrl
+
+    val rf = RegisterFile(config)
+    rf.io.rs1Addr <> idCtrl.rs1Addr
+    rf.io.rs2Addr <> idCtrl.rs2Addr
+    rf.io.rdWrCtrl.valid := wbValid & wb.rdWrite
+    rf.io.rdWrCtrl.payload.addr := wb.rdAddr
+    rf.io.rdWrCtrl.payload.data := wb.data
+
+    // The data written back in WB stage is not in the register file until the next cycle
+    def wbBypass(addr: UInt, data: Bits): Bits = {
+        val wbHit = wbValid & wb.rdWrite & wb.rdAddr === addr & addr =/= 0
+        Mux(wbHit, wb.data, data)
+    }
+
+    // Load-use hazard: the load data is available in WB stage so stall the instruction in ID stage for one cycle.
+    // rs1/rs2 are compared even if the instruction does not use them. This only causes an unnecessary stall.
+    val exRd = ex.cpuCtrl.rdAddr
+    val loadUse = ifuData.valid & exValid & ex.cpuCtrl.memRead & exRd =/= 0 &
+                  (exRd === idCtrl.rs1Addr | exRd === idCtrl.rs2Addr)
+
+    stallId := stallEx | loadUse
+    ifuData.ready := ~stallId
+
+    when(~stallEx) {
+        exValid := ifuData.valid & ~loadUse & ~redirect.valid
+        ex.cpuCtrl := idCtrl
+        ex.csrCtrl := uDec.io.csrCtrl
+        ex.rs1Data := wbBypass(idCtrl.rs1Addr, rf.io.rs1Data)
+        ex.rs2Data := wbBypass(idCtrl.rs2Addr, rf.io.rs2Data)
+        ex.pc := ifuData.payload.pc
+        exInst := ifuData.payload.instruction
+        exPredPc := ifuData.payload.predPc
+    }
+
+    // ----------------------------
+    // EX stage
+    // ----------------------------
+    val exCtrl = ex.cpuCtrl
+
+    // Forward the result from MEM and WB stage. The load in MEM stage is not forwarded (load-use hazard)
+    def forward(addr: UInt, data: Bits): Bits = {
+        val memHit = memValid & mem.cpuCtrl.rdWrite & ~mem.cpuCtrl.memRead & mem.cpuCtrl.rdAddr === addr & addr =/= 0
+        val wbHit = wbValid & wb.rdWrite & wb.rdAddr === addr & addr =/= 0
+        Mux(memHit, mem.result, Mux(wbHit, wb.data, data))
+    }
+
+    val rs1Data = forward(exCtrl.rs1Addr, ex.rs1Data)
+    val rs2Data = forward(exCtrl.rs2Addr, ex.rs2Data)
+
+    // The forwarding source can leave MEM/WB stage while EX stage is stalled (e.g. the producer in WB stage
+    // commits while a load/store stalls in MEM stage). Keep the forwarded operands in the pipeline register.
+    when(stallEx) {
+        ex.rs1Data := rs1Data
+        ex.rs2Data := rs2Data
+    }
+
+    val immediate = exCtrl.immediate.asBits
+
+    val uAlu = ALU(config)
+    val uMulDiv = MulDiv(config)
+    val uBeu = BEU(config)
+    val uCSR = CSR(config)
+    val uTrapCtrl = TrapCtrl(config)
+
+    // ALU
+    val aluSrc1 = Mux(exCtrl.aluSelPc, ex.pc.asBits, rs1Data)
+    val aluSrc2 = Mux(exCtrl.selImm,   immediate,    rs2Data)
+    uAlu.io.opcode <> exCtrl.aluOpcode
+    uAlu.io.src1 <> aluSrc1
+    uAlu.io.src2 <> aluSrc2
+
+    // MulDiv. The operands are captured at the first cycle so the forwarding source can leave
+    uMulDiv.io.valid := exValid & exCtrl.muldiv
+    uMulDiv.io.ready := ~stallMem
+    uMulDiv.io.opcode <> exCtrl.opcode
+    uMulDiv.io.src1 <> aluSrc1
+    uMulDiv.io.src2 <> aluSrc2
+    val exBusy = exValid & exCtrl.muldiv & uMulDiv.io.busy
+
+    // fence.i waits for the data cache write back. The older store in MEM stage completes first.
+    val dcacheFlush = Event
+    dcacheFlush.valid := exValid & exCtrl.fencei & ~stallMem
+    val exFlush = exValid & exCtrl.fencei & ~dcacheFlush.ready
+
+    stallEx := stallMem | exBusy | exFlush
+    val exFire = exValid & ~stallEx
+
+    // BEU
+    val branchCtrl = Flow(config.xlenUInt)
+    uBeu.io.branch <> exCtrl.branch
+    uBeu.io.jump <> exCtrl.jump
+    uBeu.io.opcode <> exCtrl.opcode
+    uBeu.io.src1 <> rs1Data
+    uBeu.io.src2 <> rs2Data
+    uBeu.io.addr <> uAlu.io.addResult
+    branchCtrl := uBeu.io.branchCtrl
+
+    // CSR. Only access the CSR when the instruction leaves EX stage
+    uCSR.io.csrCtrl.addr := ex.csrCtrl.addr
+    uCSR.io.csrCtrl.read := ex.csrCtrl.read
+    uCSR.io.csrCtrl.write := ex.csrCtrl.write & exFire
+    uCSR.io.csrCtrl.set := ex.csrCtrl.set & exFire
+    uCSR.io.csrCtrl.clear := ex.csrCtrl.clear & exFire
+    uCSR.io.csrWdata <> Mux(exCtrl.selImm, immediate, rs1Data)
+
+    // TrapCtrl
+    uTrapCtrl.io.csrRdPort <> uCSR.io.csrRdPort
+    uTrapCtrl.io.csrWrPort <> uCSR.io.csrWrPort
+    uTrapCtrl.io.ecall := exCtrl.ecall & exFire
+    uTrapCtrl.io.mret := exCtrl.mret & exFire
+    uTrapCtrl.io.trap <> uCSR.io.trap
+    uTrapCtrl.io.pc <> ex.pc
+    val trapCtrl = uTrapCtrl.io.trapCtrl
+
+    // fence.i. The instructions after it may be stale so refetch them
+    fencei := exCtrl.fencei & exFire
+
+    // Branch prediction check. The fetch is redirected when the next PC is mispredicted
+    val pcPlus4 = ex.pc + 4
+    val exNextPc = Mux(branchCtrl.valid, branchCtrl.payload, pcPlus4)
+    val mispredict = exNextPc =/= exPredPc
+    val isCtrl = exCtrl.branch | exCtrl.jump
+
+    val bpuUpdate = uIFU.io.bpuUpdate
+    bpuUpdate.valid := exFire & (isCtrl | mispredict)
+    bpuUpdate.payload.pc := ex.pc
+    bpuUpdate.payload.target := branchCtrl.payload
+    bpuUpdate.payload.taken := branchCtrl.valid
+    bpuUpdate.payload.branch := exCtrl.branch
+    bpuUpdate.payload.jump := exCtrl.jump
+    bpuUpdate.payload.call := exCtrl.jump & (exCtrl.rdAddr === 1 | exCtrl.rdAddr === 5)
+    bpuUpdate.payload.ret := exCtrl.jump & ~exCtrl.aluSelPc & exCtrl.rdAddr === 0 &
+                             (exCtrl.rs1Addr === 1 | exCtrl.rs1Addr === 5)
+
+    // Redirect the fetch
+    redirect.valid := exFire & mispredict | trapCtrl.valid | fencei
+    redirect.payload := Mux(trapCtrl.valid, trapCtrl.payload, exNextPc)
+
+    // Result
+    val exResult = Mux(ex.csrCtrl.read, uCSR.io.csrRdata,
+                   Mux(exCtrl.jump,     pcPlus4.asBits,
+                   Mux(exCtrl.muldiv,   uMulDiv.io.result,
+                                        uAlu.io.result)))
+
+    when(~stallMem) {
+        memValid := exValid & ~exBusy & ~exFlush
+        mem.cpuCtrl := exCtrl
+        mem.pc := ex.pc
+        mem.nextPc := Mux(trapCtrl.valid, trapCtrl.payload, exNextPc)
+        mem.instruction := exInst
+        mem.result := exResult
+        mem.addr := uAlu.io.addResult
+        mem.wdata := rs2Data
+    }
+
+    // ----------------------------
+    // MEM stage
+    // ----------------------------
+    val uLsu = LSU(config)
+    uLsu.io.memRead := memValid & mem.cpuCtrl.memRead
+    uLsu.io.memWrite := memValid & mem.cpuCtrl.memWrite
+    uLsu.io.opcode <> mem.cpuCtrl.opcode
+    uLsu.io.addr <> mem.addr
+    uLsu.io.wdata <> mem.wdata
+
+    // Data cache
+    val dcacheHit = Bool()
+    val dcacheMiss = Bool()
+    val dcacheWb = Bool()
+    if (config.dcache.isDefined) {
+        val uDCache = DCache(config, config.dcache.get)
+        uDCache.io.cpu <> uLsu.io.dbus
+        uDCache.io.mem <> io.dbus
+        uDCache.io.flush <> dcacheFlush
+        dcacheHit := uDCache.io.hit
+        dcacheMiss := uDCache.io.miss
+        dcacheWb := uDCache.io.writeback
+    } else {
+        val uDBusBridge = Axi4LiteToAxi4(config.axi4LiteConfig, config.axi4Config)
+        uDBusBridge.io.input <> uLsu.io.dbus
+        uDBusBridge.io.output <> io.dbus
+        dcacheFlush.ready := True
+        dcacheHit := False
+        dcacheMiss := False
+        dcacheWb := False
+    }
+
+    stallMem := uLsu.io.memRead & ~uLsu.io.rvalid | uLsu.io.memWrite & ~uLsu.io.wready
+
+    wbValid := memValid & ~stallMem
+    when(~stallMem) {
+        wb.rdWrite := mem.cpuCtrl.rdWrite
+        wb.rdAddr := mem.cpuCtrl.rdAddr
+        wb.data := Mux(mem.cpuCtrl.memRead, uLsu.io.rdata, mem.result)
+        wb.pc := mem.pc
+        wb.nextPc := mem.nextPc
+        wb.instruction := mem.instruction
+        wb.ebreak := mem.cpuCtrl.ebreak
+        wb.ecall := mem.cpuCtrl.ecall
+    }
+
+    // ----------------------------
+    // WB stage
+    // ----------------------------
+
+    // Commit interface for simulation. The instruction in WB stage is committed at the end of the cycle
+    val commitValid = CombInit(wbValid)
+    val commitPc = CombInit(wb.pc)
+    val commitNextPc = CombInit(wb.nextPc)
+    val commitInst = CombInit(wb.instruction)
+    val commitEbreak = wbValid & wb.ebreak
+    val commitEcall = wbValid & wb.ecall
+    commitValid.addAttribute(public)
+    commitPc.addAttribute(public)
+    commitNextPc.addAttribute(public)
+    commitInst.addAttribute(public)
+
+    // ----------------------------
+    // Performance counter
+    // ----------------------------
+    val perfEvent = uCSR.io.perfEvent
+    perfEvent.instret := wbValid
+    perfEvent.ifuWait := uIFU.io.fetchWait
+    perfEvent.lsuLoadWait := uLsu.io.memRead & ~uLsu.io.rvalid
+    perfEvent.lsuStoreWait := uLsu.io.memWrite & ~uLsu.io.wready
+    perfEvent.mulDivBusy := exBusy
+    perfEvent.busStall := io.busStall
+    perfEvent.icacheHit := icacheHit
+    perfEvent.icacheMiss := icacheMiss
+    perfEvent.dcacheHit := dcacheHit
+    perfEvent.dcacheMiss := dcacheMiss
+    perfEvent.dcacheWb := dcacheWb
+    perfEvent.branch := exFire & isCtrl
+    perfEvent.mispredict := exFire & mispredict
+}
+
+object CorePVerilog extends App {
+    val axi4LiteConfig = Axi4LiteConfig(addrWidth = 32, dataWidth = 32)
+    val config = RiscCoreConfig(32, 0x80000000L, 32, axi4LiteConfig=axi4LiteConfig)
+    Config.spinal.generateVerilog(CoreP(config)).printPruned()
+}
@@ -0,0 +1,332 @@
+/* ------------------------------------------------------------------------------------------------
+ * Copyright (c) 2023. Heqing Huang (feipenghhq@gmail.com)
+ *
+ * Project: NPC
+ * Author: Heqing Huang
+ * Date Created: 10/18/2026
+ *
+ * ------------------------------------------------------------------------------------------------
+ * DCache: Data Cache
+ * ------------------------------------------------------------------------------------------------
+ * DCache sits between the LSU and the data bus.
+ *  - Set associative. The size, line size and associativity are set by CacheConfig
+ *  - Write back, write allocate. Round robin replacement
+ *  - A cache line holds the bus data width words and the hit returns the same data as the bus
+ *  - The miss writes back the dirty victim line, refills the line with AXI4 INCR bursts then
+ *    replays the lookup
+ *  - The access to the uncached regions (MMIO) goes to the bus directly
+ *  - flush writes back all the dirty lines (fence.i). The lines stay valid
+ * ------------------------------------------------------------------------------------------------
+ */
+
+package core
+
+import spinal.core._
+import spinal.lib._
+import spinal.lib.fsm._
+import config._
+import _root_.bus.Axi4Lite._
+import _root_.bus.Axi4._
+
+case class DCache(config: RiscCoreConfig, cacheConfig: CacheConfig) extends Component {
+    val io = new Bundle {
+        val cpu = slave(Axi4Lite(config.axi4LiteConfig))    // LSU request
+        val mem = master(Axi4(config.axi4Config))           // Data memory AXI bus
+        val flush = slave(Event)                            // write back all the dirty lines (fence.i)
+        val hit = out port Bool()                           // cache hit. For performance counter
+        val miss = out port Bool()                          // cache miss. For performance counter
+        val writeback = out port Bool()                     // dirty line written back. For performance counter
+    }
+    noIoPrefix()
+
+    val dataWidth = config.axi4LiteConfig.dataWidth
+    val strbWidth = dataWidth / 8
+    val beatOffsetWidth = log2Up(strbWidth)
+    val beatNum = cacheConfig.lineSize * 8 / dataWidth
+    val beatWidth = log2Up(beatNum)
+    val tagWidth = config.xlen - cacheConfig.indexWidth - cacheConfig.offsetWidth
+    assert(beatNum >= 2, "Cache line should contain at least 2 bus words")
+
+    // -----------------------------
+    // Request
+    // -----------------------------
+    val addr     = Reg(config.xlenUInt)
+    val wdata    = Reg(Bits(dataWidth bits))
+    val wstrb    = Reg(Bits(strbWidth bits))
+    val isWrite  = Reg(Bool())
+    val uncached = cacheConfig.isUncached(addr)
+
+    val tag = addr(config.xlen - 1 downto config.xlen - tagWidth)
+    val index = addr(cacheConfig.offsetWidth + cacheConfig.indexWidth - 1 downto cacheConfig.offsetWidth)
+    val beat = addr(cacheConfig.offsetWidth - 1 downto beatOffsetWidth)
+
+    when(io.cpu.ar.fire) {
+        addr := io.cpu.ar.payload.araddr
+        isWrite := False
+    }
+
+    when(io.cpu.aw.fire) {
+        addr := io.cpu.aw.payload.awaddr
+        wdata := io.cpu.w.payload.wdata
+        wstrb := io.cpu.w.payload.wstrb
+        isWrite := True
+    }
+
+    // -----------------------------
+    // Storage
+    // -----------------------------
+    val valid = Vec.fill(cacheConfig.ways)(Reg(Bits(cacheConfig.sets bits)) init 0)
+    val dirty = Vec.fill(cacheConfig.ways)(Reg(Bits(cacheConfig.sets bits)) init 0)
+    val tagRam = Seq.tabulate(cacheConfig.ways)(i => Mem(UInt(tagWidth bits), cacheConfig.sets).setName(s"tagRam_$i"))
+    val dataRam = Seq.tabulate(cacheConfig.ways)(i => Mem(Bits(dataWidth bits), cacheConfig.sets * beatNum).setName(s"dataRam_$i"))
+
+    // -----------------------------
+    // Lookup
+    // -----------------------------
+    val hitWay = Vec(Bool(), cacheConfig.ways)
+    for (i <- 0 until cacheConfig.ways) {
+        hitWay(i) := valid(i)(index) & tagRam(i).readAsync(index) === tag
+    }
+    val hit = hitWay.orR
+    val hitData = MuxOH(hitWay, dataRam.map(_.readAsync(index @@ beat)))
+
+    // -----------------------------
+    // Line (refill/writeback/flush) control
+    // -----------------------------
+    val victim = Reg(Bits(cacheConfig.ways bits)) init 1    // one-hot, round robin
+    val lineBeat = Reg(UInt(beatWidth bits)) init 0
+    val lastBeat = lineBeat === beatNum - 1
+    val refilled = Reg(Bool()) init False                   // the lookup is replayed after a refill
+
+    // flush walks through all the lines
+    val flushing = Reg(Bool()) init False
+    val flushIndex = Reg(UInt(cacheConfig.indexWidth bits)) init 0
+    val flushWay = Reg(Bits(cacheConfig.ways bits)) init 1
+    val flushLast = flushIndex === cacheConfig.sets - 1 & flushWay.msb
+
+    // line to be written back
+    val wbIndex = Mux(flushing, flushIndex, index)
+    val wbWay = Mux(flushing, flushWay, victim)
+    val wbDirty = MuxOH(wbWay, (0 until cacheConfig.ways).map(i => valid(i)(wbIndex) & dirty(i)(wbIndex)))
+    val wbTag = MuxOH(wbWay, tagRam.map(_.readAsync(wbIndex)))
+    val wbData = MuxOH(wbWay, dataRam.map(_.readAsync(wbIndex @@ lineBeat)))
+
+    // -----------------------------
+    // Main control FSM
+    // -----------------------------
+    val cacheCtrl = new StateMachine {
+        setEncoding(binaryOneHot)
+        val IDLE: State = makeInstantEntry()
+        val LOOKUP, WB_REQ, WB_DATA, WB_RESP, REFILL_REQ, REFILL_DATA = new State
+        val UC_RD_REQ, UC_RD_DATA, UC_WR_REQ, UC_WR_DATA, UC_WR_RESP = new State
+        val FLUSH, FLUSH_DONE = new State
+
+        IDLE.whenIsActive {
+            when(io.cpu.ar.fire | io.cpu.aw.fire) {
+                goto(LOOKUP)
+            } elsewhen(io.flush.valid) {
+                flushing := True
+                goto(FLUSH)
+            }
+        }
+
+        LOOKUP.whenIsActive {
+            when(uncached) {
+                when(isWrite) {
+                    goto(UC_WR_REQ)
+                } otherwise {
+                    goto(UC_RD_REQ)
+                }
+            } elsewhen(io.cpu.r.fire | io.cpu.b.fire) {
+                goto(IDLE)
+            } elsewhen(~hit) {
+                when(wbDirty) {
+                    goto(WB_REQ)
+                } otherwise {
+                    goto(REFILL_REQ)
+                }
+            }
+        }
+
+        // write back the dirty line
+        WB_REQ.whenIsActive {
+            when(io.mem.aw.fire) {
+                goto(WB_DATA)
+            }
+        }
+
+        WB_DATA.whenIsActive {
+            when(io.mem.w.fire & lastBeat) {
+                goto(WB_RESP)
+            }
+        }
+
+        WB_RESP.whenIsActive {
+            when(io.mem.b.fire) {
+                when(flushing) {
+                    goto(FLUSH)
+                } otherwise {
+                    goto(REFILL_REQ)
+                }
+            }
+        }
+
+        // refill the line
+        REFILL_REQ.whenIsActive {
+            when(io.mem.ar.fire) {
+                goto(REFILL_DATA)
+            }
+        }
+
+        REFILL_DATA.whenIsActive {
+            when(io.mem.r.fire & io.mem.r.payload.rlast) {
+                goto(LOOKUP)
+            }
+        }
+
+        // uncached access
+        UC_RD_REQ.whenIsActive {
+            when(io.mem.ar.fire) {
+                goto(UC_RD_DATA)
+            }
+        }
+
+        UC_RD_DATA.whenIsActive {
+            when(io.mem.r.fire) {
+                goto(IDLE)
+            }
+        }
+
+        UC_WR_REQ.whenIsActive {
+            when(io.mem.aw.fire) {
+                goto(UC_WR_DATA)
+            }
+        }
+
+        UC_WR_DATA.whenIsActive {
+            when(io.mem.w.fire) {
+                goto(UC_WR_RESP)
+            }
+        }
+
+        UC_WR_RESP.whenIsActive {
+            when(io.mem.b.fire) {
+                goto(IDLE)
+            }
+        }
+
+        // flush: write back the dirty lines one by one
+        FLUSH.whenIsActive {
+            when(wbDirty) {
+                goto(WB_REQ)
+            } otherwise {
+                flushIndex := flushIndex + flushWay.msb.asUInt
+                flushWay := flushWay.rotateLeft(1)
+                when(flushLast) {
+                    goto(FLUSH_DONE)
+                }
+            }
+        }
+
+        FLUSH_DONE.whenIsActive {
+            flushing := False
+            goto(IDLE)
+        }
+    }
+
+    val lookup = cacheCtrl.isActive(cacheCtrl.LOOKUP) & ~uncached
+    val storeHit = lookup & hit & isWrite & io.cpu.b.fire
+    val refillFire = cacheCtrl.isActive(cacheCtrl.REFILL_DATA) & io.mem.r.fire
+    val refillDone = refillFire & io.mem.r.payload.rlast
+    val wbFire = cacheCtrl.isActive(cacheCtrl.WB_DATA) & io.mem.w.fire
+    val wbDone = cacheCtrl.isActive(cacheCtrl.WB_RESP) & io.mem.b.fire
+
+    when(refillFire | wbFire) {
+        lineBeat := lineBeat + 1
+    }
+
+    when(refillDone) {
+        victim := victim.rotateLeft(1)
+        refilled := True
+    } elsewhen(io.cpu.r.fire | io.cpu.b.fire) {
+        refilled := False
+    }
+
+    for (i <- 0 until cacheConfig.ways) {
+        dataRam(i).write(
+            address = index @@ Mux(storeHit, beat, lineBeat),
+            data = Mux(storeHit, wdata, io.mem.r.payload.rdata),
+            enable = storeHit & hitWay(i) | refillFire & victim(i),
+            mask = Mux(storeHit, wstrb, B(strbWidth bits, default -> True))
+        )
+        tagRam(i).write(index, tag, enable = refillDone & victim(i))
+
+        when(refillDone & victim(i)) {
+            valid(i)(index) := True
+            dirty(i)(index) := False
+        }
+        when(storeHit & hitWay(i)) {
+            dirty(i)(index) := True
+        }
+        when(wbDone & flushing & flushWay(i)) {
+            dirty(i)(flushIndex) := False
+        }
+    }
+
+    // -----------------------------
+    // Bus control
+    // -----------------------------
+
+    // cpu side. Read has higher priority. Write is accepted when both AW and W channel are valid.
+    val idle = cacheCtrl.isActive(cacheCtrl.IDLE)
+    val ucRead = cacheCtrl.isActive(cacheCtrl.UC_RD_DATA)
+    val ucWrite = cacheCtrl.isActive(cacheCtrl.UC_WR_RESP)
+    io.cpu.ar.ready := idle
+    io.cpu.aw.ready := idle & ~io.cpu.ar.valid & io.cpu.aw.valid & io.cpu.w.valid
+    io.cpu.w.ready := io.cpu.aw.ready
+
+    io.cpu.r.valid := lookup & hit & ~isWrite | ucRead & io.mem.r.valid
+    io.cpu.r.payload.rdata := Mux(ucRead, io.mem.r.payload.rdata, hitData)
+    io.cpu.r.payload.rresp := Mux(ucRead, io.mem.r.payload.rresp, B(0, 2 bits))
+
+    io.cpu.b.valid := lookup & hit & isWrite | ucWrite & io.mem.b.valid
+    io.cpu.b.payload.bresp := Mux(ucWrite, io.mem.b.payload.bresp, B(0, 2 bits))
+
+    io.flush.ready := cacheCtrl.isActive(cacheCtrl.FLUSH_DONE)
+
+    // memory side. The line is accessed with a burst and the uncached access is a single beat burst.
+    val ucRdReq = cacheCtrl.isActive(cacheCtrl.UC_RD_REQ)
+    val ucWrReq = cacheCtrl.isActive(cacheCtrl.UC_WR_REQ)
+    val ucWrData = cacheCtrl.isActive(cacheCtrl.UC_WR_DATA)
+    val wbSend = cacheCtrl.isActive(cacheCtrl.WB_DATA)
+
+    io.mem.ar.valid := cacheCtrl.isActive(cacheCtrl.REFILL_REQ) | ucRdReq
+    io.mem.ar.payload.araddr := Mux(ucRdReq, addr, tag @@ index @@ U(0, cacheConfig.offsetWidth bits))
+    io.mem.ar.payload.arid := 0
+    io.mem.ar.payload.arlen := Mux(ucRdReq, U(0, 8 bits), U(beatNum - 1, 8 bits))
+    io.mem.ar.payload.arsize := config.axi4Config.fullSize
+    io.mem.ar.payload.arburst := Axi4.INCR
+    io.mem.ar.payload.arprot := 0
+    io.mem.r.ready := ~ucRead | io.cpu.r.ready
+
+    io.mem.aw.valid := cacheCtrl.isActive(cacheCtrl.WB_REQ) | ucWrReq
+    io.mem.aw.payload.awaddr := Mux(ucWrReq, addr, wbTag @@ wbIndex @@ U(0, cacheConfig.offsetWidth bits))
+    io.mem.aw.payload.awid := 0
+    io.mem.aw.payload.awlen := Mux(ucWrReq, U(0, 8 bits), U(beatNum - 1, 8 bits))
+    io.mem.aw.payload.awsize := config.axi4Config.fullSize
+    io.mem.aw.payload.awburst := Axi4.INCR
+    io.mem.aw.payload.awprot := 0
+
+    io.mem.w.valid := wbSend | ucWrData
+    io.mem.w.payload.wdata := Mux(ucWrData, wdata, wbData)
+    io.mem.w.payload.wstrb := Mux(ucWrData, wstrb, B(strbWidth bits, default -> True))
+    io.mem.w.payload.wlast := ucWrData | lastBeat
+    io.mem.b.ready := ~ucWrite | io.cpu.b.ready
+
+    // -----------------------------
+    // Performance counter event
+    // -----------------------------
+    io.hit := (io.cpu.r.fire | io.cpu.b.fire) & lookup & ~refilled
+    io.miss := lookup & ~hit
+    io.writeback := wbDone
+}
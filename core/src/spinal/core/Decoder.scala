@@ -9,6 +9,7 @@
  * Decoder: Instruction Decode Unit
  * ------------------------------------------------------------------------------------------------
  * Decode the Instruction into different cpu control signal
+ * 10/18/2026: Added RV32C support. The compressed instruction is expanded by RvcExpander first
  * ------------------------------------------------------------------------------------------------
  */
 
@@ -40,6 +41,10 @@ case class CpuCtrl(config: RiscCoreConfig) extends Bundle {
     val rs2Addr = UInt(config.regidWidth bits)
     val immediate = config.xlenSInt
     val muldiv = Bool()
+    // Zifencei
+    val fencei = Bool()
+    // RV32C
+    val rvc = Bool()    // compressed instruction. The next pc is pc + 2
 }
 
 /**
@@ -62,10 +67,23 @@ case class Decoder(config: RiscCoreConfig) extends Component {
     noIoPrefix()
 
     // alias some path
-    val instruction = io.ifuData.instruction
+    val instruction = config.xlenBits
     val cpuCtrl = io.cpuCtrl
     val csrCtrl = io.csrCtrl
 
+    //-----------------------------------
+    // Compressed instruction expansion
+    //-----------------------------------
+    if (config.rvc) {
+        val rvcExpander = RvcExpander(config)
+        rvcExpander.io.input := io.ifuData.instruction
+        instruction := rvcExpander.io.output
+        cpuCtrl.rvc := rvcExpander.io.rvc
+    } else {
+        instruction := io.ifuData.instruction
+        cpuCtrl.rvc := False
+    }
+
     //-----------------------------------
     // Instruction decode
     //-----------------------------------
@@ -137,6 +155,9 @@ case class Decoder(config: RiscCoreConfig) extends Component {
     // -- RV32M --
     cpuCtrl.muldiv := rType & (funct7 === 1)
 
+    // -- Zifencei --
+    cpuCtrl.fencei := fenceType & (funct3 === 1)
+
     // -- Zicsr --
 
     // csrrw/csrrwi should not read CSR if rd = x0
@@ -33,6 +33,15 @@ case class EXU(config: RiscCoreConfig) extends Component {
         val branchCtrl = master Flow(config.xlenUInt)
         val trapCtrl = master Flow(config.xlenUInt)
         val dbus = master(Axi4Lite(config.axi4LiteConfig))
+        val fetchWait = in port Bool()  // IFU is waiting for the instruction. For performance counter
+        val busStall = in port Bool()   // bus request is blocked by the arbiter. For performance counter
+        val icacheHit = in port Bool()  // instruction cache hit. For performance counter
+        val icacheMiss = in port Bool() // instruction cache miss. For performance counter
+        val dcacheHit = in port Bool()  // data cache hit. For performance counter
+        val dcacheMiss = in port Bool() // data cache miss. For performance counter
+        val dcacheWb = in port Bool()   // data cache write back. For performance counter
+        val fencei = out port Bool()    // fence.i is executed. Invalidate the instruction cache
+        val dcacheFlush = master(Event) // write back the data cache for fence.i
     }
 
     // ----------------------------
@@ -67,7 +76,9 @@ case class EXU(config: RiscCoreConfig) extends Component {
     val aluRes = uAlu.io.result
     val aluAddRes = uAlu.io.addResult
 
-    // MulDiv
+    // MulDiv. The mul/div instruction has no other stall so the result is taken once it is available
+    uMulDiv.io.valid := io.iduData.valid & cpuCtrl.muldiv
+    uMulDiv.io.ready := True
     uMulDiv.io.opcode <> cpuCtrl.opcode
     uMulDiv.io.src1 <> aluSrc1
     uMulDiv.io.src2 <> aluSrc2
@@ -102,20 +113,42 @@ case class EXU(config: RiscCoreConfig) extends Component {
     uTrapCtrl.io.trap <> uCSR.io.trap
     uTrapCtrl.io.pc <> io.iduData.pc
 
-    // Register Write Back
-    val pcPlus4 = iduData.pc + 4
+    // Performance counter
+    val perfEvent = uCSR.io.perfEvent
+    perfEvent.instret := io.iduData.fire
+    perfEvent.ifuWait := io.fetchWait
+    perfEvent.lsuLoadWait := io.iduData.valid & cpuCtrl.memRead & ~uLsu.io.rvalid
+    perfEvent.lsuStoreWait := io.iduData.valid & cpuCtrl.memWrite & ~uLsu.io.wready
+    perfEvent.mulDivBusy := io.iduData.valid & cpuCtrl.muldiv & uMulDiv.io.busy
+    perfEvent.busStall := io.busStall
+    perfEvent.icacheHit := io.icacheHit
+    perfEvent.icacheMiss := io.icacheMiss
+    perfEvent.dcacheHit := io.dcacheHit
+    perfEvent.dcacheMiss := io.dcacheMiss
+    perfEvent.dcacheWb := io.dcacheWb
+    perfEvent.branch := io.iduData.fire & (cpuCtrl.branch | cpuCtrl.jump)
+    perfEvent.mispredict := False   // the next instruction is fetched after the branch/jump completes
+
+    // fence.i: write back the data cache first then invalidate the instruction cache. The next
+    // instruction is fetched after this one completes so no more action is needed.
+    io.dcacheFlush.valid := io.iduData.valid & cpuCtrl.fencei
+    io.fencei := io.iduData.fire & cpuCtrl.fencei
+
+    // Register Write Back. The link address of the compressed jump is pc + 2
+    val linkPc = iduData.pc + Mux(cpuCtrl.rvc, U(2), U(4))
     io.rdWrCtrl.payload.addr <> cpuCtrl.rdAddr
     io.rdWrCtrl.valid := cpuCtrl.rdWrite & io.iduData.fire
     io.rdWrCtrl.payload.data := Mux(csrCtrl.read,    uCSR.io.csrRdata,
                                 Mux(cpuCtrl.memRead, uLsu.io.rdata,
-                                Mux(cpuCtrl.jump,    pcPlus4.asBits,
+                                Mux(cpuCtrl.jump,    linkPc.asBits,
                                 Mux(cpuCtrl.muldiv,  uMulDiv.io.result.asBits,
                                                      aluRes.asBits))))
 
     // ----------------------------
     // Handshake
     // ----------------------------
-    val stall = cpuCtrl.memRead & ~uLsu.io.rvalid | cpuCtrl.memWrite & ~uLsu.io.wready
+    val stall = cpuCtrl.memRead & ~uLsu.io.rvalid | cpuCtrl.memWrite & ~uLsu.io.wready |
+                cpuCtrl.muldiv & uMulDiv.io.busy | cpuCtrl.fencei & ~io.dcacheFlush.ready
     io.iduData.ready := ~stall
 
     // for simulation
@@ -0,0 +1,180 @@
+/* ------------------------------------------------------------------------------------------------
+ * Copyright (c) 2023. Heqing Huang (feipenghhq@gmail.com)
+ *
+ * Project: NPC
+ * Author: Heqing Huang
+ * Date Created: 10/18/2026
+ *
+ * ------------------------------------------------------------------------------------------------
+ * ICache: Instruction Cache
+ * ------------------------------------------------------------------------------------------------
+ * ICache sits between the IFU and the instruction bus.
+ *  - Set associative. The size, line size and associativity are set by CacheConfig
+ *  - Round robin replacement
+ *  - A cache line holds the bus data width words and the hit returns the same data as the bus
+ *  - The miss refills the whole line with an AXI4 INCR burst then replays the lookup
+ *  - invalidate (fence.i) clears all the valid bits. A refill in progress is not marked valid
+ * ------------------------------------------------------------------------------------------------
+ */
+
+package core
+
+import spinal.core._
+import spinal.lib._
+import spinal.lib.fsm._
+import config._
+import _root_.bus.Axi4Lite._
+import _root_.bus.Axi4._
+
+case class ICache(config: RiscCoreConfig, cacheConfig: CacheConfig) extends Component {
+    val io = new Bundle {
+        val cpu = slave(Axi4Lite(config.axi4LiteConfig))    // IFU request
+        val mem = master(Axi4(config.axi4Config))           // Instruction memory AXI bus
+        val invalidate = in port Bool()                     // invalidate the whole cache (fence.i)
+        val hit = out port Bool()                           // cache hit. For performance counter
+        val miss = out port Bool()                          // cache miss. For performance counter
+    }
+    noIoPrefix()
+
+    val dataWidth = config.axi4LiteConfig.dataWidth
+    val beatOffsetWidth = log2Up(dataWidth / 8)
+    val beatNum = cacheConfig.lineSize * 8 / dataWidth
+    val beatWidth = log2Up(beatNum)
+    val tagWidth = config.xlen - cacheConfig.indexWidth - cacheConfig.offsetWidth
+    assert(beatNum >= 2, "Cache line should contain at least 2 bus words")
+
+    // -----------------------------
+    // Request
+    // -----------------------------
+    val addr = Reg(config.xlenUInt)
+    val tag = addr(config.xlen - 1 downto config.xlen - tagWidth)
+    val index = addr(cacheConfig.offsetWidth + cacheConfig.indexWidth - 1 downto cacheConfig.offsetWidth)
+    val beat = addr(cacheConfig.offsetWidth - 1 downto beatOffsetWidth)
+
+    when(io.cpu.ar.fire) {
+        addr := io.cpu.ar.payload.araddr
+    }
+
+    // -----------------------------
+    // Storage
+    // -----------------------------
+    val valid = Vec.fill(cacheConfig.ways)(Reg(Bits(cacheConfig.sets bits)) init 0)
+    val tagRam = Seq.tabulate(cacheConfig.ways)(i => Mem(UInt(tagWidth bits), cacheConfig.sets).setName(s"tagRam_$i"))
+    val dataRam = Seq.tabulate(cacheConfig.ways)(i => Mem(Bits(dataWidth bits), cacheConfig.sets * beatNum).setName(s"dataRam_$i"))
+
+    // -----------------------------
+    // Lookup
+    // -----------------------------
+    val hitWay = Vec(Bool(), cacheConfig.ways)
+    for (i <- 0 until cacheConfig.ways) {
+        hitWay(i) := valid(i)(index) & tagRam(i).readAsync(index) === tag
+    }
+    val hit = hitWay.orR
+    val hitData = MuxOH(hitWay, dataRam.map(_.readAsync(index @@ beat)))
+
+    // -----------------------------
+    // Refill
+    // -----------------------------
+    val victim = Reg(Bits(cacheConfig.ways bits)) init 1    // one-hot, round robin
+    val refillBeat = Reg(UInt(beatWidth bits)) init 0
+    val refillDone = io.mem.r.fire & io.mem.r.payload.rlast
+    val refilled = Reg(Bool()) init False                   // the lookup is replayed after a refill
+    val kill = Reg(Bool()) init False                       // the cache is invalidated during the refill
+
+    when(io.mem.r.fire) {
+        refillBeat := refillBeat + 1
+    }
+
+    when(refillDone) {
+        victim := victim.rotateLeft(1)
+        kill := False
+    }
+
+    for (i <- 0 until cacheConfig.ways) {
+        dataRam(i).write(index @@ refillBeat, io.mem.r.payload.rdata, enable = io.mem.r.fire & victim(i))
+        tagRam(i).write(index, tag, enable = refillDone & victim(i))
+        when(io.invalidate) {
+            valid(i) := 0
+        } elsewhen(refillDone & victim(i) & ~kill) {
+            valid(i)(index) := True
+        }
+    }
+
+    // -----------------------------
+    // Main control FSM
+    // -----------------------------
+    val cacheCtrl = new StateMachine {
+        setEncoding(binaryOneHot)
+        val IDLE: State = makeInstantEntry()
+        val LOOKUP, REFILL_REQ, REFILL_DATA = new State
+
+        IDLE.whenIsActive {
+            when(io.cpu.ar.fire) {
+                goto(LOOKUP)
+            }
+        }
+
+        LOOKUP.whenIsActive {
+            when(io.cpu.r.fire) {
+                goto(IDLE)
+            } elsewhen(~hit) {
+                goto(REFILL_REQ)
+            }
+        }
+
+        REFILL_REQ.whenIsActive {
+            when(io.mem.ar.fire) {
+                goto(REFILL_DATA)
+            }
+        }
+
+        REFILL_DATA.whenIsActive {
+            when(refillDone) {
+                goto(LOOKUP)
+            }
+        }
+    }
+
+    val refilling = cacheCtrl.isActive(cacheCtrl.REFILL_REQ) | cacheCtrl.isActive(cacheCtrl.REFILL_DATA)
+    when(io.invalidate & refilling) {
+        kill := True
+    }
+
+    when(refillDone) {
+        refilled := True
+    } elsewhen(io.cpu.r.fire) {
+        refilled := False
+    }
+
+    // -----------------------------
+    // Bus control
+    // -----------------------------
+    io.cpu.ar.ready := cacheCtrl.isActive(cacheCtrl.IDLE)
+    io.cpu.r.valid := cacheCtrl.isActive(cacheCtrl.LOOKUP) & hit
+    io.cpu.r.payload.rdata := hitData
+    io.cpu.r.payload.rresp := 0
+
+    io.mem.ar.valid := cacheCtrl.isActive(cacheCtrl.REFILL_REQ)
+    io.mem.ar.payload.araddr := tag @@ index @@ U(0, cacheConfig.offsetWidth bits)
+    io.mem.ar.payload.arid := 0
+    io.mem.ar.payload.arlen := beatNum - 1
+    io.mem.ar.payload.arsize := config.axi4Config.fullSize
+    io.mem.ar.payload.arburst := Axi4.INCR
+    io.mem.ar.payload.arprot := 0
+    io.mem.r.ready := True
+
+    // Write is not used for instruction cache
+    io.cpu.aw.ready := False
+    io.cpu.w.ready := False
+    io.cpu.b.valid := False
+    io.cpu.b.payload.bresp := 0
+    io.mem.aw <> io.mem.aw.getZero
+    io.mem.w <> io.mem.w.getZero
+    io.mem.b <> io.mem.b.getZero
+
+    // -----------------------------
+    // Performance counter event
+    // -----------------------------
+    io.hit := io.cpu.r.fire & ~refilled
+    io.miss := cacheCtrl.isActive(cacheCtrl.LOOKUP) & ~hit
+}
@@ -12,6 +12,15 @@
  *  - Program Counter (PC)
  *  - Instruction memory read control
  * Currently the IFU support only Multiple Cycle CPU
+ *
+ * 10/18/2026: Added RV32C support (config.rvc). The instruction is 16 bits aligned so the IFU fetches
+ * the aligned word and keeps the last fetched word in a fetch buffer:
+ *  - The instruction in the fetch buffer is issued without a new fetch. Two compressed instructions
+ *    in the same word take a single fetch.
+ *  - A 32 bits instruction at pc[1] = 1 straddles two words. Its lower half is kept and the next word
+ *    is fetched for the upper half.
+ *  - fence.i invalidates the fetch buffer.
+ * The raw (not expanded) instruction is sent to the decoder and to the trace.
  * ------------------------------------------------------------------------------------------------
  */
 
@@ -35,6 +44,9 @@ case class IFU(config: RiscCoreConfig) extends Component {
         val branchCtrl = slave Flow(config.xlenUInt)        // branch control input
         val trapCtrl = slave Flow(config.xlenUInt)          // trap (exception/interrupt) control input
         val ibus = master(Axi4Lite(config.axi4LiteConfig))  // Instruction memory AXI bus
+        val fetchWait = out port Bool()                     // waiting for the instruction. For performance counter
+        val flush = in port Bool()                          // invalidate the fetch buffer (fence.i)
+        val rstVector = in port config.xlenUInt             // pc loaded during reset
     }
     noIoPrefix()
 
@@ -45,7 +57,9 @@ case class IFU(config: RiscCoreConfig) extends Component {
     val nextPC = config.xlenUInt
     nextPC.addAttribute(public)
 
-    val pc = RegNextWhen(nextPC, io.ifuData.fire) init (config.pcRstVector)
+    val compressed = Bool()     // the current instruction is a compressed instruction
+
+    val pc = RegNextWhen(nextPC, io.ifuData.fire) init (io.rstVector)
     pc.addAttribute(public)
 
     when(io.trapCtrl.valid) {
@@ -53,58 +67,155 @@ case class IFU(config: RiscCoreConfig) extends Component {
     } elsewhen(io.branchCtrl.valid) {
         nextPC := io.branchCtrl.payload
     } otherwise {
-        nextPC := pc + 4
+        nextPC := pc + Mux(compressed, U(2), U(4))
     }
 
+    // raw instruction for tracing
+    val instruction = config.xlenBits
+    instruction.addAttribute(public)
+
     // -------------------------------------
     // Instruction memory read control
     // -------------------------------------
 
-    val ifuCtrl = new StateMachine {
-        setEncoding(binaryOneHot)
-        val IDLE: State = makeInstantEntry()
-        val REQ, DATA, STALL: State = new State
+    if (!config.rvc) {
+        val ifuCtrl = new StateMachine {
+            setEncoding(binaryOneHot)
+            val IDLE: State = makeInstantEntry()
+            val REQ, DATA, STALL: State = new State
 
-        val instruction = config.xlenBits
-        val instBuffer = Reg(config.xlenBits)
-        instruction := io.ibus.r.payload.rdata
+            val instruction = config.xlenBits
+            val instBuffer = Reg(config.xlenBits)
+            instruction := io.ibus.r.payload.rdata
 
-        IDLE.whenIsActive {
-            goto(REQ)
-        }
+            IDLE.whenIsActive {
+                goto(REQ)
+            }
 
-        REQ.whenIsActive {
-            // When AR channel handshake complete goto DATA state to wait for read data
-            when(io.ibus.ar.ready) {
-                goto(DATA)
+            REQ.whenIsActive {
+                // When AR channel handshake complete goto DATA state to wait for read data
+                when(io.ibus.ar.ready) {
+                    goto(DATA)
+                }
+            }
+
+            DATA.whenIsActive {
+                // when data is returned and ifu can move forward, goto REQ state again
+                when(io.ibus.r.valid && io.ifuData.ready) {
+                    goto(REQ)
+                }
+                // when data is returned but ifu is stalled, goto STALL state
+                // meanwhile, store the return data (instruction) to instruction buffer
+                .elsewhen(io.ibus.r.valid && !io.ifuData.ready) {
+                    instBuffer := io.ibus.r.payload.rdata
+                    goto(STALL)
+                }
+            }
+
+            STALL.whenIsActive {
+                // instruction is selected from instruction buffer
+                instruction := instBuffer
+                // ifu is ready to go, go to REQ state again
+                when(io.ifuData.ready) {
+                    goto(REQ)
+                }
             }
         }
 
-        DATA.whenIsActive {
-            // when data is returned and ifu can move forward, goto REQ state again
-            when(io.ibus.r.valid && io.ifuData.ready) {
-                goto(REQ)
+        io.ibus.ar.valid := ifuCtrl.isActive(ifuCtrl.REQ) // assert arvalid at REQ state
+        io.ibus.ar.payload.araddr := pc
+
+        compressed := False
+        instruction := ifuCtrl.instruction
+        io.ifuData.valid := io.ibus.r.fire | ifuCtrl.isActive(ifuCtrl.STALL)
+        io.fetchWait := ifuCtrl.isActive(ifuCtrl.REQ) | ifuCtrl.isActive(ifuCtrl.DATA) & ~io.ibus.r.valid
+    } else {
+        val buffer = Reg(config.xlenBits)                       // the last fetched word
+        val bufferAddr = Reg(UInt(config.xlen - 2 bits))        // word address of the buffer
+        val bufferValid = Reg(Bool()) init False
+        val lower = Reg(Bits(16 bits))                          // lower half of the straddling instruction
+        val lowerValid = Reg(Bool()) init False
+        val fetchAddr = Reg(UInt(config.xlen - 2 bits))         // word address of the fetch request
+
+        // The returned word is used at the same cycle
+        val word = Mux(io.ibus.r.fire, io.ibus.r.payload.rdata, buffer)
+        val wordAddr = Mux(io.ibus.r.fire, fetchAddr, bufferAddr)
+        val wordValid = io.ibus.r.fire | bufferValid
+        val pcWord = pc(config.xlen - 1 downto 2)
+        val wordHit = wordValid & wordAddr === pcWord
+        val nextWordHit = wordValid & wordAddr === pcWord + 1
+
+        // lower half of the instruction
+        val half0Valid = lowerValid | wordHit
+        val half0 = Mux(lowerValid, lower, Mux(pc(1), word(31 downto 16), word(15 downto 0)))
+        // upper half of the 32 bits instruction
+        val half1Valid = Mux(pc(1), lowerValid & nextWordHit, wordHit)
+        val half1 = Mux(pc(1), word(15 downto 0), word(31 downto 16))
+
+        compressed := half0(1 downto 0) =/= B"11"
+        val hit = half0Valid & (compressed | half1Valid)    // the whole instruction is available
+        instruction := Mux(compressed, B(0, 16 bits) ## half0, half1 ## half0)
+
+        val ifuCtrl = new StateMachine {
+            setEncoding(binaryOneHot)
+            val IDLE: State = makeInstantEntry()
+            val REQ, DATA: State = new State
+
+            IDLE.whenIsActive {
+                when(~hit) {
+                    goto(REQ)
+                }
             }
-            // when data is returned but ifu is stalled, goto STALL state
-            // meanwhile, store the return data (instruction) to instruction buffer
-            .elsewhen(io.ibus.r.valid && !io.ifuData.ready) {
-                instBuffer := io.ibus.r.payload.rdata
-                goto(STALL)
+
+            REQ.whenIsActive {
+                when(io.ibus.ar.ready) {
+                    goto(DATA)
+                }
+            }
+
+            DATA.whenIsActive {
+                when(io.ibus.r.valid) {
+                    when(hit) {
+                        goto(IDLE)
+                    } otherwise {
+                        goto(REQ)
+                    }
+                }
             }
         }
 
-        STALL.whenIsActive {
-            // instruction is selected from instruction buffer
-            instruction := instBuffer
-            // ifu is ready to go, go to REQ state again
-            when(io.ifuData.ready) {
-                goto(REQ)
+        val check = ifuCtrl.isActive(ifuCtrl.IDLE) | ifuCtrl.isActive(ifuCtrl.DATA) & io.ibus.r.valid
+
+        // Fetch the word of the pc, or the next word for the straddling instruction
+        when(check & ~hit) {
+            fetchAddr := Mux(half0Valid, pcWord + 1, pcWord)
+            when(half0Valid) {
+                lower := half0
+                lowerValid := True
             }
         }
+
+        when(io.ibus.r.fire) {
+            buffer := io.ibus.r.payload.rdata
+            bufferAddr := fetchAddr
+            bufferValid := True
+        }
+
+        when(io.ifuData.fire) {
+            lowerValid := False
+        }
+
+        when(io.flush) {
+            bufferValid := False
+        }
+
+        io.ibus.ar.valid := ifuCtrl.isActive(ifuCtrl.REQ)
+        io.ibus.ar.payload.araddr := fetchAddr @@ U(0, 2 bits)
+
+        io.ifuData.valid := check & hit
+        io.fetchWait := ifuCtrl.isActive(ifuCtrl.REQ) | ifuCtrl.isActive(ifuCtrl.DATA) & ~io.ibus.r.valid
     }
 
-    io.ibus.ar.valid := ifuCtrl.isActive(ifuCtrl.REQ) // assert arvalid at REQ state
-    io.ibus.ar.payload.araddr := pc
     io.ibus.r.ready := True // always ready to receive data
 
     // Write is not used for instruction memory
@@ -116,11 +227,5 @@ case class IFU(config: RiscCoreConfig) extends Component {
     // IFU data logic
     // -----------------------------
     io.ifuData.pc := pc
-    io.ifuData.instruction := ifuCtrl.instruction
-
-    // -----------------------------
-    // IFU data handshake
-    // -----------------------------
-    io.ifuData.valid := io.ibus.r.fire | ifuCtrl.isActive(ifuCtrl.STALL)
-
+    io.ifuData.instruction := instruction
 }
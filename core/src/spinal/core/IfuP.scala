@@ -0,0 +1,175 @@
+/* ------------------------------------------------------------------------------------------------
+ * Copyright (c) 2023. Heqing Huang (feipenghhq@gmail.com)
+ *
+ * Project: NPC
+ * Author: Heqing Huang
+ * Date Created: 10/18/2026
+ *
+ * ------------------------------------------------------------------------------------------------
+ * IfuP: Instruction Fetch Unit for the pipelined CPU
+ * ------------------------------------------------------------------------------------------------
+ * IfuP contains the following logic:
+ *  - Program Counter (PC) of the next fetch
+ *  - Instruction memory read control
+ *  - Instruction buffer between IF and ID stage
+ *
+ * The IFU keeps fetching the predicted instructions and push them into the instruction buffer
+ * together with the predicted PC of the next instruction. Without branch predictor, the fetch is
+ * predicted not taken. When EX stage finds the next PC is different from the predicted one, the fetch is
+ * redirected to the new PC and the instructions in the buffer are flushed. The read data of the request
+ * issued before the redirect is dropped when it comes back.
+ *
+ * Branch predictor (BpuConfig):
+ *  - STATIC: backward taken, forward not taken (BTFN). The fetched instruction is pre-decoded. JAL and
+ *    backward branch are predicted taken and the fetch is redirected to the target.
+ *  - DYNAMIC: the next fetch PC is predicted by the Bpu (BTB, BHT and RAS) when the request is issued.
+ * ------------------------------------------------------------------------------------------------
+ */
+
+package core
+
+import spinal.core._
+import spinal.lib._
+import spinal.core.Verilator._
+import config._
+import _root_.bus.Axi4Lite._
+
+/** IfuP data to the next stage */
+case class IfuPBundle(config: RiscCoreConfig) extends Bundle {
+    val pc = config.xlenUInt
+    val instruction = config.xlenBits
+    val predPc = config.xlenUInt        // predicted PC of the next instruction
+}
+
+case class IfuP(config: RiscCoreConfig) extends Component {
+    val io = new Bundle {
+        val ifuData = master Stream(IfuPBundle(config))     // IFU data to next stage
+        val redirect = slave Flow(config.xlenUInt)          // redirect the fetch and flush the fetched instructions
+        val bpuUpdate = slave Flow(BpuUpdate(config))       // branch/jump result to update the branch predictor
+        val ibus = master(Axi4Lite(config.axi4LiteConfig))  // Instruction memory AXI bus
+        val fetchWait = out port Bool()                     // waiting for the instruction. For performance counter
+        val rstVector = in port config.xlenUInt             // pc loaded during reset
+    }
+    noIoPrefix()
+
+    val flush = io.redirect.valid
+
+    // -----------------------------
+    // Program Counter (PC)
+    // -----------------------------
+
+    // PC of the next fetch
+    val pc = Reg(config.xlenUInt) init (io.rstVector)
+    pc.addAttribute(public)
+
+    // -----------------------------
+    // Instruction buffer
+    // -----------------------------
+    val instBuffer = StreamFifo(IfuPBundle(config), 2)
+    instBuffer.io.flush := flush
+    io.ifuData <> instBuffer.io.pop
+
+    // -------------------------------------
+    // Instruction memory read control
+    // -------------------------------------
+
+    val arValid = Reg(Bool()) init False    // request is not accepted by ibus yet
+    val arAddr  = Reg(config.xlenUInt)      // address of the request
+    val arPredPc = Reg(config.xlenUInt)     // predicted PC after the request
+    val pending = Reg(Bool()) init False    // request is accepted, waiting for the read data
+    val drop    = Reg(Bool()) init False    // drop the read data of the request issued before the redirect
+
+    val rFire = io.ibus.r.fire
+    val inflight = arValid | pending
+
+    // Only one outstanding request is supported by the bus. A new request can be issued at the same cycle
+    // the read data comes back. Make sure there is space in the buffer for the read data.
+    val space = instBuffer.io.occupancy + inflight.asUInt.resize(instBuffer.io.occupancy.getWidth) < 2
+    val predRedirect = Bool()   // the fetch is redirected by the static predictor
+    val issue = (~inflight | pending & rFire) & space & ~flush & ~predRedirect
+
+    // -------------------------------------
+    // Branch prediction
+    // -------------------------------------
+    val inst = io.ibus.r.payload.rdata
+    val staticPred = new Area {
+        val isJal = inst(6 downto 0) === B"1101111"
+        val isBranch = inst(6 downto 0) === B"1100011"
+        val jalImm = (inst(31) ## inst(19 downto 12) ## inst(20) ## inst(30 downto 21) ## False).asSInt
+        val branchImm = (inst(31) ## inst(7) ## inst(30 downto 25) ## inst(11 downto 8) ## False).asSInt
+        val imm = Mux(isJal, jalImm.resize(config.xlen), branchImm.resize(config.xlen))
+        val taken = isJal | isBranch & inst(31)
+        val target = arAddr + imm.asUInt
+    }
+
+    val nextPc = config.xlenUInt    // PC after the issued request
+    val predPc = config.xlenUInt    // predicted PC after the returned instruction
+    predRedirect := False
+    config.bpu match {
+        case Some(bpuConfig) if bpuConfig.bpuType == BpuType.DYNAMIC =>
+            val uBpu = Bpu(config, bpuConfig)
+            uBpu.io.pc := pc
+            uBpu.io.fire := issue
+            uBpu.io.update << io.bpuUpdate
+            nextPc := Mux(uBpu.io.taken, uBpu.io.target, pc + 4)
+            predPc := arPredPc
+        case Some(_) =>
+            nextPc := pc + 4
+            predPc := Mux(staticPred.taken, staticPred.target, arAddr + 4)
+            predRedirect := rFire & ~drop & ~flush & staticPred.taken
+        case None =>
+            nextPc := pc + 4
+            predPc := arAddr + 4
+    }
+
+    when(issue) {
+        arValid := True
+        arAddr := pc
+        arPredPc := nextPc
+        pc := nextPc
+    }
+
+    when(predRedirect) {
+        pc := staticPred.target
+    }
+
+    when(io.ibus.ar.fire) {
+        arValid := False
+        pending := True
+    }
+
+    when(rFire) {
+        pending := False
+        drop := False
+    }
+
+    when(flush) {
+        pc := io.redirect.payload
+        when(arValid | pending & ~rFire) {
+            drop := True
+        }
+    }
+
+    io.ibus.ar.valid := arValid
+    io.ibus.ar.payload.araddr := arAddr
+    io.ibus.ar.payload.arprot := 0
+    io.ibus.r.ready := True // always ready to receive data
+
+    // Write is not used for instruction memory
+    io.ibus.aw <> io.ibus.aw.getZero
+    io.ibus.w <> io.ibus.w.getZero
+    io.ibus.b <> io.ibus.b.getZero
+
+    // -----------------------------
+    // Push the instruction to buffer
+    // -----------------------------
+    instBuffer.io.push.valid := rFire & ~drop & ~flush
+    instBuffer.io.push.payload.pc := arAddr
+    instBuffer.io.push.payload.instruction := io.ibus.r.payload.rdata
+    instBuffer.io.push.payload.predPc := predPc
+
+    // -----------------------------
+    // Performance counter event
+    // -----------------------------
+    io.fetchWait := ~instBuffer.io.pop.valid & inflight
+}
@@ -7,8 +7,17 @@
  *
  * ------------------------------------------------------------------------------------------------
  * MulDiv: Multiplier and Divider
- * open: Currently just use the operator *, /, and % for the calculation.
- * Will need to replace them with the actual hardware logic
+ * ------------------------------------------------------------------------------------------------
+ * 10/18/2026: Replaced the *, / and % operator with the multi-cycle hardware logic
+ *  - Multiplier: 2 stage pipeline. The 33x33 multiplication is split into four 17x17 partial
+ *    products in the first stage and the partial products are summed in the second stage.
+ *  - Divider: Radix-4 restoring divider on the absolute value of the operands. Two quotient bits
+ *    are generated per cycle. The leading zero bit pairs of the dividend are skipped and the division
+ *    completes early when the dividend is smaller than the divisor or the divisor is zero.
+ *
+ * Handshake: The calculation starts when valid is asserted. busy is asserted until the result is
+ * available and the result is held until the instruction leaves the stage (valid & ready).
+ * The operands are captured at the first cycle so they can change during the calculation.
  * ------------------------------------------------------------------------------------------------
  */
 
@@ -16,73 +25,179 @@ package core
 
 import spinal.core._
 import spinal.lib._
+import spinal.lib.fsm._
 import config._
 
 case class MulDiv(config: RiscCoreConfig) extends Component {
     val io = new Bundle {
+        val valid = in port Bool()      // a mul/div instruction is in the stage
+        val ready = in port Bool()      // the stage can take the result
         val opcode = in port Bits(3 bits)
         val src1 = in port config.xlenBits
         val src2 = in port config.xlenBits
         val result = out port config.xlenBits
+        val busy = out port Bool()      // calculation is in progress
     }
     noIoPrefix()
 
+    val xlen = config.xlen
+    val isDiv = io.opcode(2)
+
+    val done = Reg(Bool()) init False   // the result is available
+    val result = Reg(config.xlenBits)
+    val idle = Bool()
+    val start = io.valid & ~done & idle
+
+    when(io.valid & io.ready & done) {
+        done := False
+    }
+
     // Calculate signed and unsigned mul/div needs different multiplier and divider.
     // To save resource, we want share the multiplier and divider logic for both
     // signed and unsigned operation. To achieve this, we add one additional bit to
     // the original input and extend the original input. For signed operation, we do
     // signed extension. For unsigned operation, we add 0 so the value are treated as
-    // positive. With the new value, we can use one signed multiplier and divider.
-
-    // Note: Currently just use the *, /, and % operator
+    // positive. With the new value, we can use one signed multiplier.
     val multiplier = new Area {
-        val mulSrc1 = SInt(config.xlen + 1 bits)
-        val mulSrc2 = SInt(config.xlen + 1 bits)
-
-        mulSrc1(config.xlen-1 downto 0) := io.src1.asSInt
-        mulSrc1(config.xlen) := io.src1.msb & (io.opcode(1 downto 0) =/= B"11")
-
-        mulSrc2(config.xlen-1 downto 0) := io.src2.asSInt
-        mulSrc2(config.xlen) := io.src2.msb & (io.opcode(1 downto 0) === B"01" | io.opcode(1 downto 0) === B"00")
-
-        val mulFullResult = mulSrc1 * mulSrc2
-        val mulResult = mulFullResult(0, config.xlen bits)
-        val mulhResult = mulFullResult(config.xlen, config.xlen bits)
+        val mulSrc1 = SInt(xlen + 1 bits)
+        val mulSrc2 = SInt(xlen + 1 bits)
+
+        mulSrc1(xlen-1 downto 0) := io.src1.asSInt
+        mulSrc1(xlen) := io.src1.msb & (io.opcode(1 downto 0) =/= B"11")
+
+        mulSrc2(xlen-1 downto 0) := io.src2.asSInt
+        mulSrc2(xlen) := io.src2.msb & (io.opcode(1 downto 0) === B"01" | io.opcode(1 downto 0) === B"00")
+
+        // Stage 1: partial products. Each source is split into a 16 bits unsigned low part and a
+        // 17 bits signed high part.
+        val src1Lo = mulSrc1(15 downto 0).asUInt
+        val src1Hi = mulSrc1(xlen downto 16)
+        val src2Lo = mulSrc2(15 downto 0).asUInt
+        val src2Hi = mulSrc2(xlen downto 16)
+
+        val s1Valid = RegNext(start & ~isDiv) init False
+        val mulh = Reg(Bool())
+        val prodLoLo = Reg(UInt(32 bits))
+        val prodLoHi = Reg(SInt(34 bits))
+        val prodHiLo = Reg(SInt(34 bits))
+        val prodHiHi = Reg(SInt(34 bits))
+
+        when(start) {
+            mulh := io.opcode(1 downto 0) =/= B"00"
+            prodLoLo := src1Lo * src2Lo
+            prodLoHi := (False ## src1Lo).asSInt * src2Hi
+            prodHiLo := src1Hi * (False ## src2Lo).asSInt
+            prodHiHi := src1Hi * src2Hi
+        }
+
+        // Stage 2: sum the partial products
+        val prodMid = (prodLoHi +^ prodHiLo).resize(50 bits)
+        val mulFullResult = (prodHiHi << 32).resize(66 bits) +
+                            (prodMid << 16).resize(66 bits) +
+                            (False ## prodLoLo).asSInt.resize(66 bits)
+        val mulResult = mulFullResult(0, xlen bits)
+        val mulhResult = mulFullResult(xlen, xlen bits)
+
+        when(s1Valid) {
+            result := Mux(mulh, mulhResult, mulResult).asBits
+            done := True
+        }
     }
 
     val divider = new Area {
-        val divSrc1 = SInt(config.xlen + 1 bits)
-        val divSrc2 = SInt(config.xlen + 1 bits)
-
-        divSrc1(config.xlen-1 downto 0) := io.src1.asSInt
-        divSrc1(config.xlen) := io.src1.msb & ~io.opcode(0)
-
-        divSrc2(config.xlen-1 downto 0) := io.src2.asSInt
-        divSrc2(config.xlen) := io.src2.msb & ~io.opcode(0)
-
-        val divResult = divSrc1 / divSrc2
-        val remResult = divSrc1 % divSrc2
-
-        // processing corner condition
-        val mostNegInt = B(config.xlen bit, config.xlen-1 -> true, default -> false)
-        val minusOne = B(config.xlen bit, default -> true)
-
         val unsign = io.opcode(0)
-        val zero = io.src2 === 0
-        val overflow = ~unsign & (io.src2 === minusOne) & (io.src1 === mostNegInt)
-
-        val divResFinal = Mux(overflow, mostNegInt,
-                          Mux(zero,     minusOne,
-                                        divResult(0, config.xlen bit).asBits))
-        val remResFinal = Mux(overflow, B(0, config.xlen bits),
-                          Mux(zero,     io.src1,
-                                        remResult(0, config.xlen bit).asBits))
+        val src1Neg = io.src1.msb & ~unsign
+        val src2Neg = io.src2.msb & ~unsign
+
+        val dividend = Reg(UInt(xlen bits))     // absolute value of the dividend
+        val divisor = Reg(UInt(xlen bits))      // absolute value of the divisor
+        val quotNeg = Reg(Bool())
+        val remNeg = Reg(Bool())
+        val isRem = Reg(Bool())
+        val quot = Reg(UInt(xlen bits))         // the dividend bits are shifted out and the quotient bits are shifted in
+        val rem = Reg(UInt(xlen bits))
+        val cnt = Reg(UInt(log2Up(xlen / 2) bits))
+
+        // 2 bits per iteration: compare the partial remainder with 1x, 2x and 3x of the divisor
+        val partial = rem @@ quot(xlen-1 downto xlen-2)
+        val divisor1 = divisor.resize(xlen + 2 bits)
+        val divisor2 = (divisor << 1).resize(xlen + 2 bits)
+        val divisor3 = divisor1 + divisor2
+        val digit = UInt(2 bits)
+        val sub = UInt(xlen + 2 bits)
+        when(partial >= divisor3) {
+            digit := 3
+            sub := partial - divisor3
+        } elsewhen(partial >= divisor2) {
+            digit := 2
+            sub := partial - divisor2
+        } elsewhen(partial >= divisor1) {
+            digit := 1
+            sub := partial - divisor1
+        } otherwise {
+            digit := 0
+            sub := partial
+        }
+
+        // Skip the leading zero bit pairs of the dividend
+        val leadingZero = OHToUInt(OHMasking.first(dividend.asBits.reversed))
+        val skip = leadingZero(leadingZero.getWidth - 1 downto 1)
+
+        val divCtrl = new StateMachine {
+            setEncoding(binaryOneHot)
+            val IDLE: State = makeInstantEntry()
+            val PREP, CALC, FIX = new State
+
+            IDLE.whenIsActive {
+                when(start & isDiv) {
+                    dividend := Mux(src1Neg, ~io.src1.asUInt + 1, io.src1.asUInt)
+                    divisor := Mux(src2Neg, ~io.src2.asUInt + 1, io.src2.asUInt)
+                    // divide by zero: quotient is all 1s and remainder is the dividend
+                    quotNeg := (src1Neg ^ src2Neg) & (io.src2 =/= 0)
+                    remNeg := src1Neg
+                    isRem := io.opcode(1)
+                    goto(PREP)
+                }
+            }
+
+            PREP.whenIsActive {
+                rem := 0
+                when(divisor === 0) {
+                    quot.setAll()
+                    rem := dividend
+                    goto(FIX)
+                } elsewhen(dividend < divisor) {
+                    quot := 0
+                    rem := dividend
+                    goto(FIX)
+                } otherwise {
+                    quot := (dividend << (skip @@ U"0")).resize(xlen bits)
+                    cnt := U(xlen / 2 - 1, cnt.getWidth bits) - skip
+                    goto(CALC)
+                }
+            }
+
+            CALC.whenIsActive {
+                quot := quot(xlen-3 downto 0) @@ digit
+                rem := sub.resize(xlen bits)
+                cnt := cnt - 1
+                when(cnt === 0) {
+                    goto(FIX)
+                }
+            }
+
+            FIX.whenIsActive {
+                val quotFinal = Mux(quotNeg, ~quot + 1, quot)
+                val remFinal = Mux(remNeg, ~rem + 1, rem)
+                result := Mux(isRem, remFinal, quotFinal).asBits
+                done := True
+                goto(IDLE)
+            }
+        }
     }
 
-    switch(io.opcode) {
-        is(B"000")                 {io.result := multiplier.mulResult.asBits}
-        is(B"001", B"010", B"011") {io.result := multiplier.mulhResult.asBits}
-        is(B"100", B"101")         {io.result := divider.divResFinal}
-        is(B"110", B"111")         {io.result := divider.remResFinal}
-    }
+    idle := ~multiplier.s1Valid & divider.divCtrl.isActive(divider.divCtrl.IDLE)
+
+    io.result := result
+    io.busy := io.valid & ~done
 }
@@ -0,0 +1,202 @@
+/* ------------------------------------------------------------------------------------------------
+ * Copyright (c) 2023. Heqing Huang (feipenghhq@gmail.com)
+ *
+ * Project: NPC
+ * Author: Heqing Huang
+ * Date Created: 10/18/2026
+ *
+ * ------------------------------------------------------------------------------------------------
+ * RvcExpander: Expand the RV32C compressed instruction into the equivalent 32 bits instruction
+ * ------------------------------------------------------------------------------------------------
+ * The expander sits in front of the decoder so the rest of the decoder only sees the 32 bits
+ * instructions. The 32 bits instruction (instruction[1:0] = 11) is passed through.
+ * The floating point load/store are not supported and the reserved/illegal compressed instructions
+ * are expanded into 0 (an illegal instruction).
+ * ------------------------------------------------------------------------------------------------
+ */
+
+package core
+
+import spinal.core._
+import spinal.lib._
+import config._
+
+object RvcExpander {
+    // 32 bits instruction opcode
+    def OP_LUI    = B"0110111"
+    def OP_JAL    = B"1101111"
+    def OP_JALR   = B"1100111"
+    def OP_BRANCH = B"1100011"
+    def OP_LOAD   = B"0000011"
+    def OP_STORE  = B"0100011"
+    def OP_IMM    = B"0010011"
+    def OP_OP     = B"0110011"
+    def OP_SYSTEM = B"1110011"
+
+    // 32 bits instruction format
+    def iType(imm: Bits, rs1: Bits, funct3: Bits, rd: Bits, opcode: Bits): Bits =
+        imm.resize(12) ## rs1 ## funct3 ## rd ## opcode
+
+    def sType(imm: Bits, rs2: Bits, rs1: Bits, funct3: Bits, opcode: Bits): Bits = {
+        val imm12 = imm.resize(12)
+        imm12(11 downto 5) ## rs2 ## rs1 ## funct3 ## imm12(4 downto 0) ## opcode
+    }
+
+    def bType(imm: Bits, rs2: Bits, rs1: Bits, funct3: Bits, opcode: Bits): Bits = {
+        val imm13 = imm.resize(13)
+        imm13(12) ## imm13(10 downto 5) ## rs2 ## rs1 ## funct3 ## imm13(4 downto 1) ## imm13(11) ## opcode
+    }
+
+    def uType(imm: Bits, rd: Bits, opcode: Bits): Bits =
+        imm.resize(20) ## rd ## opcode
+
+    def jType(imm: Bits, rd: Bits, opcode: Bits): Bits = {
+        val imm21 = imm.resize(21)
+        imm21(20) ## imm21(10 downto 1) ## imm21(11) ## imm21(19 downto 12) ## rd ## opcode
+    }
+
+    def rType(funct7: Bits, rs2: Bits, rs1: Bits, funct3: Bits, rd: Bits, opcode: Bits): Bits =
+        funct7 ## rs2 ## rs1 ## funct3 ## rd ## opcode
+
+    def sext(value: Bits, width: Int): Bits = value.asSInt.resize(width).asBits
+}
+
+case class RvcExpander(config: RiscCoreConfig) extends Component {
+    val io = new Bundle {
+        val input = in port config.xlenBits     // raw instruction. The compressed one is in the lower 16 bits
+        val output = out port config.xlenBits   // expanded instruction
+        val rvc = out port Bool()               // the input is a compressed instruction
+    }
+    noIoPrefix()
+
+    import RvcExpander._
+
+    val inst = io.input(15 downto 0)
+    val quadrant = inst(1 downto 0)
+    val funct3 = inst(15 downto 13)
+
+    // Register fields. The 3 bits register field (rd'/rs1'/rs2') addresses x8 - x15
+    val rd = inst(11 downto 7)
+    val rs1 = inst(11 downto 7)
+    val rs2 = inst(6 downto 2)
+    val rdp = B"01" ## inst(4 downto 2)
+    val rs1p = B"01" ## inst(9 downto 7)
+    val rs2p = B"01" ## inst(4 downto 2)
+    val x0 = B"00000"
+    val x1 = B"00001"
+    val x2 = B"00010"
+
+    // Immediate
+    val addi4spnImm = inst(10 downto 7) ## inst(12 downto 11) ## inst(5) ## inst(6) ## B"00"
+    val lwImm = inst(5) ## inst(12 downto 10) ## inst(6) ## B"00"
+    val imm6 = sext(inst(12) ## inst(6 downto 2), 12)
+    val jImm = sext(inst(12) ## inst(8) ## inst(10 downto 9) ## inst(6) ## inst(7) ## inst(2) ## inst(11) ##
+                    inst(5 downto 3) ## False, 21)
+    val bImm = sext(inst(12) ## inst(6 downto 5) ## inst(2) ## inst(11 downto 10) ## inst(4 downto 3) ## False, 13)
+    val addi16spImm = sext(inst(12) ## inst(4 downto 3) ## inst(5) ## inst(2) ## inst(6) ## B"0000", 12)
+    val luiImm = sext(inst(12) ## inst(6 downto 2), 20)
+    val lwspImm = inst(3 downto 2) ## inst(12) ## inst(6 downto 4) ## B"00"
+    val swspImm = inst(8 downto 7) ## inst(12 downto 9) ## B"00"
+    val shamt = inst(6 downto 2)
+
+    val expanded = config.xlenBits
+    expanded := 0
+
+    switch(quadrant ## funct3) {
+        // -- Quadrant 0 --
+        is(B"00000") {  // c.addi4spn
+            when(inst(12 downto 5) =/= 0) {
+                expanded := iType(addi4spnImm, x2, B"000", rdp, OP_IMM)
+            }
+        }
+        is(B"00010") {  // c.lw
+            expanded := iType(lwImm, rs1p, B"010", rdp, OP_LOAD)
+        }
+        is(B"00110") {  // c.sw
+            expanded := sType(lwImm, rs2p, rs1p, B"010", OP_STORE)
+        }
+        // -- Quadrant 1 --
+        is(B"01000") {  // c.addi/c.nop
+            expanded := iType(imm6, rd, B"000", rd, OP_IMM)
+        }
+        is(B"01001") {  // c.jal
+            expanded := jType(jImm, x1, OP_JAL)
+        }
+        is(B"01010") {  // c.li
+            expanded := iType(imm6, x0, B"000", rd, OP_IMM)
+        }
+        is(B"01011") {  // c.addi16sp/c.lui
+            when(rd === 2) {
+                expanded := iType(addi16spImm, x2, B"000", x2, OP_IMM)
+            } otherwise {
+                expanded := uType(luiImm, rd, OP_LUI)
+            }
+            when(inst(12) ## inst(6 downto 2) === 0) {
+                expanded := 0
+            }
+        }
+        is(B"01100") {  // c.srli/c.srai/c.andi/c.sub/c.xor/c.or/c.and
+            switch(inst(11 downto 10)) {
+                is(B"00") { expanded := rType(B"0000000", shamt, rs1p, B"101", rs1p, OP_IMM) }  // c.srli
+                is(B"01") { expanded := rType(B"0100000", shamt, rs1p, B"101", rs1p, OP_IMM) }  // c.srai
+                is(B"10") { expanded := iType(imm6, rs1p, B"111", rs1p, OP_IMM) }               // c.andi
+                is(B"11") {
+                    val funct = Vec(B"0100000000", B"0000000100", B"0000000110", B"0000000111")  // sub/xor/or/and
+                    val sel = funct(inst(6 downto 5).asUInt)
+                    expanded := rType(sel(9 downto 3), rs2p, rs1p, sel(2 downto 0), rs1p, OP_OP)
+                }
+            }
+            // shamt[5] must be 0 for RV32C. c.subw/c.addw are RV64C only
+            when(inst(12) & (inst(11 downto 10) =/= B"10")) {
+                expanded := 0
+            }
+        }
+        is(B"01101") {  // c.j
+            expanded := jType(jImm, x0, OP_JAL)
+        }
+        is(B"01110") {  // c.beqz
+            expanded := bType(bImm, x0, rs1p, B"000", OP_BRANCH)
+        }
+        is(B"01111") {  // c.bnez
+            expanded := bType(bImm, x0, rs1p, B"001", OP_BRANCH)
+        }
+        // -- Quadrant 2 --
+        is(B"10000") {  // c.slli
+            when(~inst(12)) {
+                expanded := rType(B"0000000", shamt, rd, B"001", rd, OP_IMM)
+            }
+        }
+        is(B"10010") {  // c.lwsp
+            when(rd =/= 0) {
+                expanded := iType(lwspImm, x2, B"010", rd, OP_LOAD)
+            }
+        }
+        is(B"10100") {  // c.jr/c.mv/c.ebreak/c.jalr/c.add
+            when(~inst(12)) {
+                when(rs2 === 0) {
+                    when(rs1 =/= 0) {
+                        expanded := iType(B"0", rs1, B"000", x0, OP_JALR)           // c.jr
+                    }
+                } otherwise {
+                    expanded := rType(B"0000000", rs2, x0, B"000", rd, OP_OP)       // c.mv
+                }
+            } otherwise {
+                when(rs2 === 0) {
+                    when(rs1 === 0) {
+                        expanded := iType(B"1", x0, B"000", x0, OP_SYSTEM)          // c.ebreak
+                    } otherwise {
+                        expanded := iType(B"0", rs1, B"000", x1, OP_JALR)           // c.jalr
+                    }
+                } otherwise {
+                    expanded := rType(B"0000000", rs2, rd, B"000", rd, OP_OP)       // c.add
+                }
+            }
+        }
+        is(B"10110") {  // c.swsp
+            expanded := sType(swspImm, rs2, x2, B"010", OP_STORE)
+        }
+    }
+
+    io.rvc := quadrant =/= B"11"
+    io.output := Mux(io.rvc, expanded, io.input)
+}
@@ -17,17 +17,24 @@ import spinal.lib._
 import config._
 import common._
 import _root_.bus.Axi4Lite._
+import _root_.bus.Axi4._
 import core.CoreN
 import core.CoreNVerilog.axi4LiteConfig
 
 
 case class CoreNSoC(config: RiscCoreConfig) extends Component {
-    val ibus = Axi4Lite(config.axi4LiteConfig)
-    val dbus = Axi4Lite(config.axi4LiteConfig)
+    val io = new Bundle {
+        val rstVector = in port config.xlenUInt     // pc loaded during reset, driven by the testbench
+    }
+    noIoPrefix()
+
+    val ibus = Axi4(config.axi4Config)
+    val dbus = Axi4(config.axi4Config)
 
     val core = CoreN(config)
     ibus <> core.io.ibus
     dbus <> core.io.dbus
+    core.io.rstVector := io.rstVector
 
     val pc = core.uIFU.io.ifuData.payload.pc.pull()
 
@@ -39,28 +46,33 @@ case class CoreNSoC(config: RiscCoreConfig) extends Component {
 
     // using two separate sram for instruction and data memory
     if (config.separateSram) {
-        val uIfuSram = Axi4LiteRam(config, RamType.DPI)
+        val uIfuSram = Axi4Ram(config, RamType.DPI)
         uIfuSram.io.ifetch := True
         uIfuSram.io.pc := pc
-        uIfuSram.io.axi4l <> ibus
+        uIfuSram.io.axi4 <> ibus
 
-        val uLsuSram = Axi4LiteRam(config, RamType.DPI)
+        val uLsuSram = Axi4Ram(config, RamType.DPI)
         uLsuSram.io.ifetch := False
         uLsuSram.io.pc := pc
-        uLsuSram.io.axi4l <> dbus
+        uLsuSram.io.axi4 <> dbus
+
+        core.io.busStall := False
     }
     // using single sram for instruction and data memory
     else {
-        // arbitrate between the 2 buses
-        val axiArbiter = Axi4LiteArbiter(config.axi4LiteConfig, 2, false)
-        val sramAxi4l = Axi4Lite(config.axi4LiteConfig)
+        // arbitrate between the 2 buses. Each bus has one request in flight so the fetch and
+        // the data access can overlap with 2 outstanding transactions.
+        val axiArbiter = Axi4Arbiter(config.axi4Config.copy(outstanding = 2), 2)
+        val sramAxi4 = Axi4(config.axi4Config)
         axiArbiter.io.input <> Vec(ibus, dbus)
-        axiArbiter.io.output <> sramAxi4l
+        axiArbiter.io.output <> sramAxi4
+        core.io.busStall := axiArbiter.io.stall
 
-        val sram = Axi4LiteRam(config, RamType.DPI)
-        sram.io.ifetch := ibus.ar.valid
+        val sram = Axi4Ram(config, RamType.DPI)
+        // the read request is a fetch when the ibus is granted
+        sram.io.ifetch := sramAxi4.ar.valid & axiArbiter.io.arGrantId === 0
         sram.io.pc := pc
-        sram.io.axi4l <> sramAxi4l
+        sram.io.axi4 <> sramAxi4
     }
 }
 
@@ -82,6 +94,8 @@ case class CoreNDpi (config: RiscCoreConfig) extends BlackBox {
 
 object CoreNSoCVerilog extends App {
     val axi4LiteConfig = Axi4LiteConfig(addrWidth = 32, dataWidth = 32)
-    val config = RiscCoreConfig(32, 0x80000000L, 32, separateSram=false, axi4LiteConfig=axi4LiteConfig)
+    val config = RiscCoreConfig(32, 0x80000000L, 32, separateSram=false, icache=Some(CacheConfig()),
+                                dcache=Some(CacheConfig(uncached=Seq((0xa0000000L, 0x20000000L)))),
+                                axi4LiteConfig=axi4LiteConfig)
     Config.spinal.generateVerilog(CoreNSoC(config)).printPruned()
 }
\ No newline at end of file
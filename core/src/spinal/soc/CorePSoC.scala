@@ -0,0 +1,88 @@
+/* ------------------------------------------------------------------------------------------------
+ * Copyright (c) 2023. Heqing Huang (feipenghhq@gmail.com)
+ *
+ * Project: NPC
+ * Author: Heqing Huang
+ * Date Created: 10/18/2026
+ *
+ * ------------------------------------------------------------------------------------------------
+ * CorePSoC: SoC for the pipelined core CoreP. Same as CoreNSoC except the core
+ * ------------------------------------------------------------------------------------------------
+ */
+
+package soc
+
+import spinal.core._
+import spinal.lib._
+import config._
+import common._
+import _root_.bus.Axi4Lite._
+import _root_.bus.Axi4._
+import core.CoreP
+
+
+case class CorePSoC(config: RiscCoreConfig) extends Component {
+    val io = new Bundle {
+        val rstVector = in port config.xlenUInt     // pc loaded during reset, driven by the testbench
+    }
+    noIoPrefix()
+
+    val ibus = Axi4(config.axi4Config)
+    val dbus = Axi4(config.axi4Config)
+
+    val core = CoreP(config)
+    ibus <> core.io.ibus
+    dbus <> core.io.dbus
+    core.io.rstVector := io.rstVector
+
+    // pc of the memory access for tracing
+    val ifetchPc = ibus.ar.payload.araddr
+    val memPc = core.mem.pc.pull()
+
+    // DPI for verilator simulation. ebreak and ecall are reported when they are committed
+    val uCoreNDpi = CoreNDpi(config)
+    uCoreNDpi.io.ebreak := core.commitEbreak.pull()
+    uCoreNDpi.io.ecall := core.commitEcall.pull()
+    uCoreNDpi.io.pc := core.commitPc.pull()
+
+    // using two separate sram for instruction and data memory
+    if (config.separateSram) {
+        val uIfuSram = Axi4Ram(config, RamType.DPI)
+        uIfuSram.io.ifetch := True
+        uIfuSram.io.pc := ifetchPc
+        uIfuSram.io.axi4 <> ibus
+
+        val uLsuSram = Axi4Ram(config, RamType.DPI)
+        uLsuSram.io.ifetch := False
+        uLsuSram.io.pc := memPc
+        uLsuSram.io.axi4 <> dbus
+
+        core.io.busStall := False
+    }
+    // using single sram for instruction and data memory
+    else {
+        // arbitrate between the 2 buses. Each bus has one request in flight so the fetch and
+        // the data access can overlap with 2 outstanding transactions.
+        val axiArbiter = Axi4Arbiter(config.axi4Config.copy(outstanding = 2), 2)
+        val sramAxi4 = Axi4(config.axi4Config)
+        axiArbiter.io.input <> Vec(ibus, dbus)
+        axiArbiter.io.output <> sramAxi4
+        core.io.busStall := axiArbiter.io.stall
+
+        val sram = Axi4Ram(config, RamType.DPI)
+        // the read request is a fetch when the ibus is granted
+        val ifetch = sramAxi4.ar.valid & axiArbiter.io.arGrantId === 0
+        sram.io.ifetch := ifetch
+        sram.io.pc := Mux(ifetch, ifetchPc, memPc)
+        sram.io.axi4 <> sramAxi4
+    }
+}
+
+object CorePSoCVerilog extends App {
+    val axi4LiteConfig = Axi4LiteConfig(addrWidth = 32, dataWidth = 32)
+    val config = RiscCoreConfig(32, 0x80000000L, 32, separateSram=false, icache=Some(CacheConfig()),
+                                dcache=Some(CacheConfig(uncached=Seq((0xa0000000L, 0x20000000L)))),
+                                bpu=Some(BpuConfig()),
+                                axi4LiteConfig=axi4LiteConfig)
+    Config.spinal.generateVerilog(CorePSoC(config)).printPruned()
+}
@@ -17,6 +17,7 @@ import spinal.lib._
 import core._
 import config.RiscCoreConfig
 import _root_.bus.Axi4Lite._
+import _root_.bus.Axi4._
 
 case class YsyxSoC(config: RiscCoreConfig) extends Component {
     val io = new Bundle {
@@ -29,16 +30,21 @@ case class YsyxSoC(config: RiscCoreConfig) extends Component {
     io.device.updateSignalName("io_slave")
     io.device <> io.device.getZero
 
-    val ibus = Axi4Lite(config.axi4LiteConfig)
-    val dbus = Axi4Lite(config.axi4LiteConfig)
+    val ibus = Axi4(config.axi4Config)
+    val dbus = Axi4(config.axi4Config)
 
-    val axiArbiter = Axi4LiteArbiter(config.axi4LiteConfig, 2)
+    // the burst from the core is split into single requests on the AXI4 Lite host port
+    val axiArbiter = Axi4Arbiter(config.axi4Config, 2)
+    val axiBridge = Axi4ToAxi4Lite(config.axi4Config, config.axi4LiteConfig)
     axiArbiter.io.input <> Vec(ibus, dbus)
-    axiArbiter.io.output <> io.host
+    axiArbiter.io.output <> axiBridge.io.input
+    axiBridge.io.output <> io.host
 
     val core = CoreN(config)
     ibus <> core.io.ibus
     dbus <> core.io.dbus
+    core.io.busStall := axiArbiter.io.stall
+    core.io.rstVector := U(config.pcRstVector, config.xlen bits)
 
     val uCoreNDpi = CoreNDpi(config)
     uCoreNDpi.io.ebreak := core.iduData.cpuCtrl.ebreak.pull()
@@ -58,6 +64,6 @@ object YsyxConfig {
 
 object YsyxSoCVerilog extends App {
     val axi4LiteConfig = Axi4LiteConfig(addrWidth = 32, dataWidth = 64)
-    val config = RiscCoreConfig(32, 0x20000000L, 32, axi4LiteConfig=axi4LiteConfig)
+    val config = RiscCoreConfig(32, 0x20000000L, 32, icache=Some(CacheConfig()), axi4LiteConfig=axi4LiteConfig)
     YsyxConfig.spinal.generateVerilog(YsyxSoC(config)).printPruned()
 }
\ No newline at end of file
@@ -0,0 +1,69 @@
+/* ------------------------------------------------------------------------------------------------
+ * Copyright (c) 2023. Heqing Huang (feipenghhq@gmail.com)
+ *
+ * Project: NPC
+ * Author: Heqing Huang
+ * Date Created: 10/18/2026
+ *
+ * ------------------------------------------------------------------------------------------------
+ * RamBurstDpi: Ram using verilog dpi. Read or write a whole burst with a single DPI call
+ * ------------------------------------------------------------------------------------------------
+ */
+
+module RamBurstDpi #(
+    parameter XLEN       = 32,
+    parameter DATA_WIDTH = 32,
+    parameter MAX_BURST  = 16
+) (
+    input  logic                                clk,
+    input  logic                                rst_b,
+    input  logic                                ifetch, // for traceing
+    input  logic [XLEN-1:0]                     rpc,    // for traceing
+    input  logic [XLEN-1:0]                     wpc,    // for traceing
+    input  logic                                rvalid,
+    input  logic [XLEN-1:0]                     raddr,
+    input  logic [7:0]                          rlen,
+    output logic [MAX_BURST*DATA_WIDTH-1:0]     rdata,
+    input  logic                                wvalid,
+    input  logic [XLEN-1:0]                     waddr,
+    input  logic [7:0]                          wlen,
+    input  logic [MAX_BURST*DATA_WIDTH-1:0]     wdata,
+    input  logic [MAX_BURST*DATA_WIDTH/8-1:0]   wstrb
+);
+
+    localparam WORD_PER_BEAT = DATA_WIDTH / 32;
+
+    // -------------------------------------------
+    // _Verilator DPI
+    // -------------------------------------------
+    `ifdef VERILATOR
+
+        import "DPI-C" function void dpi_pmem_read_burst(input int pc, input int addr, input int nword,
+                                                         output bit [MAX_BURST*DATA_WIDTH-1:0] rdata,
+                                                         input bit ifetch);
+        import "DPI-C" function void dpi_pmem_write_burst(input int pc, input int addr, input int nword,
+                                                          input bit [MAX_BURST*DATA_WIDTH-1:0] wdata,
+                                                          input bit [MAX_BURST*DATA_WIDTH/8-1:0] wstrb);
+
+        bit [MAX_BURST*DATA_WIDTH-1:0] _rdata;
+
+        // Both read and write access the memory at the end of the clock. Read data is available at
+        // the next clock to mimic synchronous ram. Write goes first if both of them are valid.
+        always @(posedge clk) begin
+            if (!rst_b) begin
+                rdata <= 0;
+            end
+            else begin
+                if (wvalid) begin
+                    dpi_pmem_write_burst(wpc, waddr, (int'(wlen) + 1) * WORD_PER_BEAT, wdata, wstrb);
+                end
+                if (rvalid) begin
+                    dpi_pmem_read_burst(rpc, raddr, (int'(rlen) + 1) * WORD_PER_BEAT, _rdata, ifetch);
+                    rdata <= _rdata;
+                end
+            end
+        end
+
+    `endif
+
+endmodule
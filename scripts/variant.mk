@@ -0,0 +1,102 @@
+# ------------------------------------------------------------------------------------------------
+# Copyright (c) 2023. Heqing Huang (feipenghhq@gmail.com)
+#
+# Project: NRC
+# Author: Heqing Huang
+# Date Created: 10/18/2026
+# ------------------------------------------------------------------------------------------------
+
+# Build variants of the verilator model
+#
+#   THREADS=N   Evaluate the model with N threads (verilator --threads)
+#   PGO=gen     Instrumented build to collect the profile (verilator --prof-pgo and gcc -fprofile-generate)
+#   PGO=use     Build with the profile collected by the PGO=gen build and the training run
+#
+# Each variant is built in its own directory: $(OUTPUT_DIR)/build/<TOP>/t<THREADS>[-pgo]
+#
+# Targets:
+#   pgo         Build the instrumented model, run the training workload and rebuild with the profile
+#   speedup     Build and run the benchmark with each variant and report the speedup
+#
+# The flow makefile should define TOP, OBJECT, OUTPUT_DIR and BENCH_CMD before including this file.
+# $(call BENCH_CMD,exe) is the command to run the benchmark (also the PGO training workload) with exe.
+
+THREADS ?= 1
+PGO ?=
+
+VARIANT    = t$(THREADS)$(if $(PGO),-pgo)
+BUILD_ROOT = $(OUTPUT_DIR)/build/$(TOP)
+BUILD_DIR  = $(BUILD_ROOT)/$(VARIANT)
+PGO_DIR    = $(OUTPUT_DIR)/pgo/$(TOP)/t$(THREADS)
+
+FLOW_MAKE = $(MAKE) -f $(firstword $(MAKEFILE_LIST))
+
+ifneq ($(THREADS),1)
+VFLAGS += --threads $(THREADS)
+endif
+
+ifeq ($(PGO),gen)
+PGO_CFLAGS  = -fprofile-generate=$(PGO_DIR) -fprofile-update=atomic
+PGO_LDFLAGS = -fprofile-generate=$(PGO_DIR)
+ifneq ($(THREADS),1)
+VFLAGS += --prof-pgo
+endif
+endif
+
+ifeq ($(PGO),use)
+PGO_CFLAGS  = -fprofile-use=$(PGO_DIR) -fprofile-partial-training -Wno-missing-profile
+PGO_LDFLAGS = -fprofile-use=$(PGO_DIR)
+# thread schedule profile written by the training run
+VFLAGS += $(wildcard $(PGO_DIR)/profile.vlt)
+endif
+
+ifneq ($(PGO),)
+VFLAGS += -CFLAGS "$(PGO_CFLAGS)" -LDFLAGS "$(PGO_LDFLAGS)"
+endif
+
+## --------------------------------------------------------
+## Profile guided optimization
+## --------------------------------------------------------
+
+PGO_BUILD_DIR = $(BUILD_ROOT)/t$(THREADS)-pgo
+
+### remove the objects so the model is rebuilt with the new compiler flags
+pgo.clean_obj:
+	@rm -f $(PGO_BUILD_DIR)/.VPASS $(PGO_BUILD_DIR)/.BPASS
+	@if [ -d $(PGO_BUILD_DIR) ]; then find $(PGO_BUILD_DIR) -name "*.o" -delete; fi
+
+pgo:
+	@echo "--> Building PGO instrumented model with $(THREADS) threads"
+	@$(FLOW_MAKE) pgo.clean_obj THREADS=$(THREADS)
+	@$(FLOW_MAKE) build THREADS=$(THREADS) PGO=gen
+	@echo "--> Running PGO training workload"
+	@rm -rf $(PGO_DIR) && mkdir -p $(PGO_DIR)
+	@cd $(PGO_DIR) && $(call BENCH_CMD,$(PGO_BUILD_DIR)/$(OBJECT)) > train.log
+	@echo "--> Building model with the profile"
+	@$(FLOW_MAKE) pgo.clean_obj THREADS=$(THREADS)
+	@$(FLOW_MAKE) build THREADS=$(THREADS) PGO=use
+
+## --------------------------------------------------------
+## Speedup report
+## --------------------------------------------------------
+
+SPEEDUP_THREADS ?= 1 2 4
+SPEEDUP_PGO_THREADS ?= $(lastword $(SPEEDUP_THREADS))
+SPEEDUP_VARIANTS = $(addprefix t,$(SPEEDUP_THREADS)) t$(SPEEDUP_PGO_THREADS)-pgo
+SPEEDUP_DIR = $(OUTPUT_DIR)/speedup
+
+speedup:
+	@rm -rf $(SPEEDUP_DIR) && mkdir -p $(SPEEDUP_DIR)
+	@for t in $(SPEEDUP_THREADS); do $(FLOW_MAKE) build THREADS=$$t || exit 1; done
+	@$(FLOW_MAKE) pgo THREADS=$(SPEEDUP_PGO_THREADS)
+	@echo "--> Running benchmark: $(SPEEDUP_VARIANTS)"
+	@for v in $(SPEEDUP_VARIANTS); do \
+		mkdir -p $(SPEEDUP_DIR)/$$v && cd $(SPEEDUP_DIR)/$$v && \
+		$(call BENCH_CMD,$(BUILD_ROOT)/$$v/$(OBJECT)) > bench.log; \
+		printf "%s %s\n" $$v `sed -n 's/.*Simulation speed: \([0-9]*\) cycles\/s.*/\1/p' bench.log` \
+			>> $(SPEEDUP_DIR)/result; \
+	done
+	@printf "%-12s %15s %8s\n" Variant Cycles/s Speedup
+	@awk 'NR == 1 {base = $$2} {printf "%-12s %15d %7.2fx\n", $$1, $$2, base ? $$2 / base : 0}' $(SPEEDUP_DIR)/result
+
+.PHONY: pgo pgo.clean_obj speedup
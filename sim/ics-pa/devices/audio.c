@@ -104,4 +104,18 @@ void init_audio_SDL() {
   SDL_PauseAudio(0);
 }
 
+#ifdef CONFIG_CHECKPOINT
+
+// the audio registers and the stream buffer are in the mmio space
+void audio_save(ckpt_t *c) {
+    ckpt_write_var(c, sbuf_tail);
+}
+
+void audio_restore(ckpt_t *c) {
+    ckpt_read_var(c, sbuf_tail);
+    if (audio_regs[reg_init]) init_audio_SDL();
+}
+
+#endif
+
 #endif
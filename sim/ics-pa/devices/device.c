@@ -21,6 +21,22 @@ static IOMap devices[NUM_DEVICE];
 static int nr_device = 0;
 bool NRC_SDL_quit = false;
 
+// Page table to map the MMIO address to the device.
+// Each page is either mapped to a single device or, if the page is shared by several devices
+// (all the device registers are in the first page), to a word granular sub table.
+#define IO_PAGE_SHIFT   12
+#define IO_PAGE_SIZE    (1 << IO_PAGE_SHIFT)
+#define IO_PAGE_MASK    (IO_PAGE_SIZE - 1)
+#define IO_NR_PAGE      ((MMIO_SIZE + IO_PAGE_SIZE - 1) >> IO_PAGE_SHIFT)
+#define IO_NR_SUB       (IO_PAGE_SIZE / sizeof(word_t))
+
+typedef struct IOPage {
+    IOMap *map;     // device covering the whole page
+    IOMap **sub;    // word granular table for page shared by several devices
+} IOPage;
+
+static IOPage io_pages[IO_NR_PAGE];
+
 void init_serial();
 void init_timer();
 void init_vgactl();
@@ -32,6 +48,54 @@ void vga_update_screen();
 void vga_close_screen();
 void send_key(SDL_Event *event);
 void sdl();
+#ifdef CONFIG_CHECKPOINT
+void timer_save(ckpt_t *c);
+void timer_restore(ckpt_t *c);
+void keyboard_save(ckpt_t *c);
+void keyboard_restore(ckpt_t *c);
+void audio_save(ckpt_t *c);
+void audio_restore(ckpt_t *c);
+#endif
+
+static void list_device();
+
+/**
+ * Map the address range of a device into the page table
+ */
+static void map_device(IOMap *map) {
+    size_t start = (size_t) map->start - MMIO_BASE;
+    size_t end = (size_t) map->end - MMIO_BASE;
+    Check((size_t) map->start >= MMIO_BASE && end < MMIO_SIZE,
+          "Device %s is out of the MMIO space", map->name);
+    for (size_t page = start >> IO_PAGE_SHIFT; page <= end >> IO_PAGE_SHIFT; page++) {
+        size_t page_start = page << IO_PAGE_SHIFT;
+        size_t page_end = page_start + IO_PAGE_SIZE - 1;
+        IOPage *p = &io_pages[page];
+        if (p->map) {
+            list_device();
+            Panic("Device %s overlaps with device %s", map->name, p->map->name);
+        }
+        // the device covers the whole page
+        if (!p->sub && start <= page_start && end >= page_end) {
+            p->map = map;
+            continue;
+        }
+        // the device covers part of the page
+        if (!p->sub) {
+            p->sub = (IOMap **) calloc(IO_NR_SUB, sizeof(IOMap *));
+            CheckMalloc(p->sub);
+        }
+        size_t lo = (start > page_start ? start : page_start) & IO_PAGE_MASK;
+        size_t hi = (end < page_end ? end : page_end) & IO_PAGE_MASK;
+        for (size_t i = lo / sizeof(word_t); i <= hi / sizeof(word_t); i++) {
+            if (p->sub[i]) {
+                list_device();
+                Panic("Device %s overlaps with device %s", map->name, p->sub[i]->name);
+            }
+            p->sub[i] = map;
+        }
+    }
+}
 
 /**
  * Add a device to device list
@@ -42,6 +106,7 @@ void add_device(const char *name, void *start, void *end, device_callback callba
     devices[nr_device].start = start;
     devices[nr_device].end = end;
     devices[nr_device].callback = callback;
+    map_device(&devices[nr_device]);
     nr_device++;
 }
 
@@ -55,16 +120,21 @@ static void list_device() {
 }
 
 /**
- * search for device index in device list
+ * search for device in the page table
  */
-static int search_device(word_t addr) {
-    int i;
-    for (i = 0; i < nr_device; i++) {
-        if ((size_t) addr >= (size_t) devices[i].start && (size_t) addr <= (size_t) devices[i].end)
-            return i;
+static inline IOMap *search_device(word_t addr) {
+    word_t offset = addr - MMIO_BASE;
+    IOMap *map = NULL;
+    if (likely(offset < MMIO_SIZE)) {
+        IOPage *p = &io_pages[offset >> IO_PAGE_SHIFT];
+        if (likely(p->map != NULL)) return p->map;
+        if (p->sub) map = p->sub[(offset & IO_PAGE_MASK) / sizeof(word_t)];
     }
-    list_device();
-    Panic("Failed to find device at addr 0x%08x", addr);
+    if (unlikely(!map)) {
+        list_device();
+        Panic("Failed to find device at addr 0x%08x", addr);
+    }
+    return map;
 }
 
 /**
@@ -101,13 +171,45 @@ void update_device() {
     sdl();
 }
 
+#ifdef CONFIG_CHECKPOINT
+
+/**
+ * Save the device state that is not in the mmio space
+ */
+void device_save(ckpt_t *c) {
+#ifdef CONFIG_HAS_TIMER
+    timer_save(c);
+#endif
+#ifdef CONFIG_HAS_KEYBOARD
+    keyboard_save(c);
+#endif
+#ifdef CONFIG_HAS_AUDIO
+    audio_save(c);
+#endif
+}
+
+void device_restore(ckpt_t *c) {
+#ifdef CONFIG_HAS_TIMER
+    timer_restore(c);
+#endif
+#ifdef CONFIG_HAS_KEYBOARD
+    keyboard_restore(c);
+#endif
+#ifdef CONFIG_HAS_AUDIO
+    audio_restore(c);
+#endif
+}
+
+#endif
+
 /**
  * Access device
  */
 void device_access(word_t addr, word_t data, bool is_write, byte_t *mmio) {
-    int device = search_device(addr);
-    if (devices[device].callback) {
-        devices[device].callback(addr, data, is_write, mmio);
+    IOMap *map = search_device(addr);
+    // pure memory region such as framebuffer and sbuf has no callback function
+    if (map->callback) {
+        map->callback(addr, data, is_write, mmio);
     }
 }
 
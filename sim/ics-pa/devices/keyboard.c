@@ -96,5 +96,23 @@ void send_key(SDL_Event *event) {
     }
 }
 
+#ifdef CONFIG_CHECKPOINT
+
+void keyboard_save(ckpt_t *c) {
+    ckpt_write_var(c, keyqueue);
+    ckpt_write_var(c, head);
+    ckpt_write_var(c, tail);
+    ckpt_write_var(c, depth);
+}
+
+void keyboard_restore(ckpt_t *c) {
+    ckpt_read_var(c, keyqueue);
+    ckpt_read_var(c, head);
+    ckpt_read_var(c, tail);
+    ckpt_read_var(c, depth);
+}
+
+#endif
+
 #endif
 
@@ -6,6 +6,13 @@
  * Date Created: 01/02/2024
  *
  * ------------------------------------------------------------------------------------------------
+ * 10/18/2026: Added the virtual timer (CONFIG_TIMER_VIRTUAL). The time is derived from the simulated
+ * cycles and CONFIG_TIMER_FREQ_MHZ instead of the host clock so the run is deterministic.
+ * With CONFIG_TIMER_IDLE_SKIP, the guest is treated as spinning on the timer when it reads the timer
+ * again within CONFIG_TIMER_IDLE_GAP cycles. The time is then fast forwarded by a skip that doubles
+ * on each spinning read, up to CONFIG_TIMER_IDLE_MAX_SKIP us. The skip restarts from 1 us when the
+ * guest stops spinning so the overshoot of a busy-wait loop is bounded by the maximum skip.
+ * ------------------------------------------------------------------------------------------------
  */
 
 #include "config.h"
@@ -18,6 +25,8 @@
 #endif
 #include "device.h"
 
+uint64_t sim_cycle();
+
 #define TIMER_SIZE 8
 #define TIMER_BASE RTC_ADDR
 #define TIMER_END  (TIMER_BASE + TIMER_SIZE - 1)
@@ -25,6 +34,33 @@
 static const char name[] = "timer";
 static time_t start = 0;
 
+#ifdef CONFIG_TIMER_VIRTUAL
+
+static time_t skipped = 0;              // total time fast forwarded
+
+#ifdef CONFIG_TIMER_IDLE_SKIP
+static uint64_t last_read = 0;          // cycle of the last timer read
+static time_t skip = 1;                 // time to fast forward at the next spinning read
+
+static void idle_skip() {
+    uint64_t cycle = sim_cycle();
+    if (cycle - last_read < CONFIG_TIMER_IDLE_GAP) {
+        skipped += skip;
+        skip = skip * 2 > CONFIG_TIMER_IDLE_MAX_SKIP ? CONFIG_TIMER_IDLE_MAX_SKIP : skip * 2;
+    }
+    else {
+        skip = 1;
+    }
+    last_read = cycle;
+}
+#endif
+
+inline static time_t _get_usec() {
+    return sim_cycle() / CONFIG_TIMER_FREQ_MHZ + skipped;
+}
+
+#else
+
 inline static time_t _get_usec() {
 #ifdef CONFIG_TIMER_CLOCK_GETTIME
     struct timespec now;
@@ -40,9 +76,15 @@ inline static time_t _get_usec() {
 #endif
 }
 
+#endif
+
 void timer_callback(word_t addr, word_t data, bool is_write, byte_t *mmio) {
     Check(!is_write, "timer only support read mode");
     time_t usec, current;
+#ifdef CONFIG_TIMER_IDLE_SKIP
+    // the 64 bits time is read as two words. Only the lower word read is checked for spinning
+    if (addr == TIMER_BASE) idle_skip();
+#endif
     current = _get_usec();
     usec = current - start;
     uint64_t *timer_regs = (uint64_t *) (mmio + (TIMER_BASE - MMIO_BASE));
@@ -55,4 +97,28 @@ void init_timer() {
     start = _get_usec();
 }
 
+#ifdef CONFIG_CHECKPOINT
+
+// the elapsed time is saved so the guest time continues from the checkpoint after restore
+void timer_save(ckpt_t *c) {
+    time_t elapsed = _get_usec() - start;
+    ckpt_write_var(c, elapsed);
+#ifdef CONFIG_TIMER_IDLE_SKIP
+    ckpt_write_var(c, last_read);
+    ckpt_write_var(c, skip);
+#endif
+}
+
+void timer_restore(ckpt_t *c) {
+    time_t elapsed;
+    ckpt_read_var(c, elapsed);
+    start = _get_usec() - elapsed;
+#ifdef CONFIG_TIMER_IDLE_SKIP
+    ckpt_read_var(c, last_read);
+    ckpt_read_var(c, skip);
+#endif
+}
+
+#endif
+
 #endif
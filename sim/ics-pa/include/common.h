@@ -35,6 +35,14 @@ typedef struct test_info {
     char *dut;      // rtl top level
     char *elf;      // test elf file
     char *ref;      // Reference for difftest
+    size_t msize;   // memory size
+    uint64_t max_cycle;     // cycle budget of the test. 0 for no limit
+    char *restore;  // checkpoint file to restore from
+    uint64_t ckpt_interval; // auto checkpoint interval in cycles. 0 to disable
+    char *wave;     // waveform file. NULL to disable waveform
+    uint64_t wave_start;    // waveform start cycle
+    uint64_t wave_end;      // waveform end cycle
+    char *wave_trigger;     // waveform trigger
 } test_info;
 
 #endif
@@ -26,8 +26,7 @@
 // Memory
 //----------------------------------------------
 #define MEM_BASE        0x80000000
-#define MSIZE           0x8000000
-#define MEM_END         (MEM_BASE + MSIZE - 1)
+#define MSIZE           0x8000000   // default memory size. Can be changed with --msize
 
 //----------------------------------------------
 // ICS AM MMIO Map
@@ -12,6 +12,7 @@
 
 
 #include "common.h"
+#include "checkpoint.h"
 
 typedef void (*device_callback)(word_t addr, word_t data, bool is_write, byte_t *mmio);
 
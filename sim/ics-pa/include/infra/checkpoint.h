@@ -0,0 +1,36 @@
+// ------------------------------------------------------------------------------------------------
+// Copyright (c) 2023. Heqing Huang (feipenghhq@gmail.com)
+//
+// Project: NRC
+// Author: Heqing Huang
+// Date Created: 10/18/2026
+//
+// ------------------------------------------------------------------------------------------------
+// Checkpoint: save and restore the C side simulation state
+// ------------------------------------------------------------------------------------------------
+
+#ifndef __INFRA_CHECKPOINT_H__
+#define __INFRA_CHECKPOINT_H__
+
+#include "config.h"
+
+#ifdef CONFIG_CHECKPOINT
+
+#include "common.h"
+
+// checkpoint file. Implemented by the testbench on top of the verilator save/restore stream
+typedef struct ckpt ckpt_t;
+
+void ckpt_write(ckpt_t *c, const void *data, size_t size);
+void ckpt_read(ckpt_t *c, void *data, size_t size);
+void ckpt_write_pages(ckpt_t *c, const byte_t *base, size_t size);
+void ckpt_read_pages(ckpt_t *c, byte_t *base, size_t size);
+
+#define ckpt_write_var(c, var)  ckpt_write(c, &(var), sizeof(var))
+#define ckpt_read_var(c, var)   ckpt_read(c, &(var), sizeof(var))
+
+void ckpt_save_state(ckpt_t *c);
+void ckpt_restore_state(ckpt_t *c);
+
+#endif
+#endif
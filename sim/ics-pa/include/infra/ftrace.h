@@ -17,6 +17,7 @@
 #include <string.h>
 #include "common.h"
 #include "ringbuf.h"
+#include "tsink.h"
 
 void ftrace_init(const char *elf);
 void ftrace_close();
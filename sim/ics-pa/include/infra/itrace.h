@@ -11,12 +11,29 @@
 #define __ITRACE_H__
 
 #include "config.h"
+#include "common.h"
+
+// The record format is defined without CONFIG_ITRACE so itrace-decode can read a log file
+// written by a build with a different config
+
+// instruction trace record. Also the record format in the binary log file
+typedef struct itrace_rec {
+    word_t pc;
+    word_t inst;
+} itrace_rec;
+
+// RV32C: the compressed instruction (inst[1:0] != 2'b11) is 2 bytes
+#define INST_SIZE(inst)     ((((inst) & 0x3) == 0x3) ? 4 : 2)
+
+// header of the binary log file
+#define ITRACE_MAGIC        "NRCITRC1"
+#define ITRACE_MAGIC_LEN    8
 
 #ifdef CONFIG_ITRACE
 
 #include <string.h>
-#include "common.h"
 #include "ringbuf.h"
+#include "tsink.h"
 
 void itrace_init();
 void itrace_close();
@@ -17,6 +17,7 @@
 #include <string.h>
 #include "common.h"
 #include "ringbuf.h"
+#include "tsink.h"
 
 void mtrace_init();
 void mtrace_close();
@@ -10,22 +10,55 @@
 #ifndef __INFRA_IRINGBUF_H_
 #define __INFRA_IRINGBUF_H_
 
-typedef struct ringbuf_node {
-    char *buf;
-    bool vld;
-} ringbuf_node;
+#include "common.h"
 
+#define CACHE_LINE 64
+
+// Trace record. All the tracers store the raw data in the record and
+// the record is only formatted into text when it is printed.
+typedef struct trace_rec {
+    word_t pc;
+    word_t inst;
+    word_t addr;
+    word_t data;
+    uint8_t strb;
+    uint8_t flags;      // tracer specific flags
+    uint64_t cycle;
+} trace_rec;
+
+// Function to format a record into text
+typedef void (*ringbuf_fmt)(const trace_rec *rec, char *msg, int size);
+
+// The ring buffer is single-producer/single-consumer safe:
+// - The producer (simulation) always writes and overwrites the oldest record when the buffer is full.
+// - The consumer (e.g. a background thread writing log) reads the records in order. Records overwritten
+//   before they are read are dropped.
 typedef struct ringbuf {
-    ringbuf_node *node;
-    int size;       // size of each ring buffer entry
-    int entry;      // ring buffer entry size
-    int head;       // point to the current position of the ringbuf
+    trace_rec *rec;     // records. Contiguous and cache line aligned
+    uint32_t entry;     // number of entry. Power of 2
+    uint32_t mask;
+    int size;           // size of the formatted message
+    ringbuf_fmt fmt;
+    uint64_t head __attribute__((aligned(CACHE_LINE)));  // number of records written by producer
+    uint64_t tail __attribute__((aligned(CACHE_LINE)));  // number of records read by consumer
+    uint64_t lost;                                       // number of records dropped for consumer
 } ringbuf;
 
-
-ringbuf *ringbuf_create(int entry, int size);
+ringbuf *ringbuf_create(int entry, int size, ringbuf_fmt fmt);
 void ringbuf_delete(ringbuf *rb);
-void ringbuf_write(ringbuf *rb, char *str);
 void ringbuf_print(ringbuf *rb);
+bool ringbuf_read(ringbuf *rb, trace_rec *rec);
+
+/**
+ * Write a record to the ring buffer (producer)
+ */
+static inline void ringbuf_write(ringbuf *rb, const trace_rec *rec) {
+    uint64_t head = rb->head;
+    rb->rec[head & rb->mask] = *rec;
+    __atomic_store_n(&rb->head, head + 1, __ATOMIC_RELEASE);
+}
+
+// current simulation cycle
+uint64_t sim_cycle();
 
 #endif
@@ -17,6 +17,7 @@
 #include <string.h>
 #include "common.h"
 #include "ringbuf.h"
+#include "tsink.h"
 
 void strace_init();
 void strace_close();
@@ -13,6 +13,7 @@
 #include "mtrace.h"
 #include "ftrace.h"
 #include "strace.h"
+#include "tsink.h"
 
 void init_trace(const char *elf);
 void close_trace();
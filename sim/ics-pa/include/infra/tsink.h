@@ -0,0 +1,40 @@
+// ------------------------------------------------------------------------------------------------
+// Copyright (c) 2023. Heqing Huang (feipenghhq@gmail.com)
+//
+// Project: NRC
+// Author: Heqing Huang
+// Date Created: 10/18/2026
+//
+// ------------------------------------------------------------------------------------------------
+// Trace sink: write the trace log from a background thread
+// ------------------------------------------------------------------------------------------------
+
+#ifndef __INFRA_TSINK_H__
+#define __INFRA_TSINK_H__
+
+#include "config.h"
+
+#ifdef CONFIG_TRACE_SINK
+
+#include "common.h"
+#include "ringbuf.h"
+
+// Function to encode a record into the log. Return the number of bytes written to buf
+typedef int (*tsink_enc)(const trace_rec *rec, char *buf, int size);
+
+typedef struct tsink tsink;
+
+tsink *tsink_open(const char *name, const char *header, ringbuf_fmt fmt, int size, tsink_enc enc);
+ringbuf *tsink_ringbuf(tsink *sink);
+void tsink_start();
+void tsink_stop();
+
+/**
+ * Send a record to the log. Never blocks: the oldest record is dropped if the writer is behind
+ */
+static inline void tsink_write(tsink *sink, const trace_rec *rec) {
+    ringbuf_write(tsink_ringbuf(sink), rec);
+}
+
+#endif
+#endif
@@ -0,0 +1,22 @@
+/* ------------------------------------------------------------------------------------------------
+ * Copyright (c) 2023. Heqing Huang (feipenghhq@gmail.com)
+ *
+ * Project: NRC
+ * Author: Heqing Huang
+ * Date Created: 10/18/2026
+ *
+ * ------------------------------------------------------------------------------------------------
+ * loader: ELF loader
+ * ------------------------------------------------------------------------------------------------
+ */
+
+#ifndef __MEMORY_LOADER_H__
+#define __MEMORY_LOADER_H__
+
+#include "common.h"
+
+const void *elf_open(const char *name);
+bool is_elf(const char *name);
+size_t load_elf(const char *name, word_t *entry);
+
+#endif
@@ -15,7 +15,10 @@
 
 #include "common.h"
 
-size_t load_image(const char *img);
+extern size_t pmem_size;
+
+void init_mem(size_t size);
+size_t load_image(const char *img, word_t *entry);
 
 word_t pmem_read(word_t addr, bool ifetch);
 void pmem_write(word_t addr, word_t data, char strb);
@@ -24,7 +27,7 @@ void paddr_write(word_t addr, word_t data, char strb);
 word_t paddr_read(word_t addr, bool ifetch);
 
 inline bool in_pmem(word_t addr) {
-    return (addr >= MEM_BASE) && (addr <= MEM_END);
+    return (word_t) (addr - MEM_BASE) < pmem_size;
 }
 
 #endif
@@ -6,7 +6,8 @@
  * Date Created: 12/19/2023
  *
  * ------------------------------------------------------------------------------------------------
- *  CoreN class: Provide environment for CPU design
+ *  Core class: Provide environment for CPU design
+ *  The verilator model is selected by TOP_<top> at compile time: CoreNSoC (default) or CorePSoC
  * ------------------------------------------------------------------------------------------------
  */
 
@@ -15,16 +16,41 @@
 
 
 #include <verilated.h>
-#include <verilated_vcd_c.h>
+
+#if defined(TOP_CorePSoC)
+
+#include "VCorePSoC.h"
+#include "VCorePSoC_CorePSoC.h"
+#include "VCorePSoC_CoreP.h"
+#include "VCorePSoC_IfuP.h"
+#include "VCorePSoC_CSR.h"
+#include "VCorePSoC_RegisterFile.h"
+#include "VCorePSoC__Dpi.h"
+
+#define TOP  CorePSoC
+#define VTOP VCorePSoC
+
+// PC is the PC of the next fetch
+#define PC              top->CorePSoC->core->uIFU->pc
+#define REGS            top->CorePSoC->core->rf->regs
+#define PERF_CSR        top->CorePSoC->core->uCSR
+// Commit interface: the instruction in WB stage is committed at the end of the cycle
+#define COMMIT_VALID    top->CorePSoC->core->commitValid
+#define COMMIT_PC       top->CorePSoC->core->commitPc
+#define COMMIT_NEXT_PC  top->CorePSoC->core->commitNextPc
+#define COMMIT_INST     top->CorePSoC->core->commitInst
+
+#else
+
 #include "VCoreNSoC.h"
 #include "VCoreNSoC_CoreNSoC.h"
 #include "VCoreNSoC_CoreN.h"
 #include "VCoreNSoC_IFU.h"
 #include "VCoreNSoC_IDU.h"
 #include "VCoreNSoC_EXU.h"
+#include "VCoreNSoC_CSR.h"
 #include "VCoreNSoC_RegisterFile.h"
 #include "VCoreNSoC__Dpi.h"
-#include "Dut.h"
 
 #define TOP  CoreNSoC
 #define VTOP VCoreNSoC
@@ -34,12 +60,27 @@
 #define INSTRUCTION     top->CoreNSoC->core->uIFU->instruction
 #define DONE            top->CoreNSoC->core->uEXU->done
 #define REGS            top->CoreNSoC->core->uIDU->rf->regs
+#define PERF_CSR        top->CoreNSoC->core->uEXU->uCSR
+// Commit interface: the instruction in EXU is committed at the end of the cycle when DONE is set
+#define COMMIT_VALID    DONE
+#define COMMIT_PC       PC
+#define COMMIT_NEXT_PC  NEXT_PC
+#define COMMIT_INST     INSTRUCTION
 
-class TOP: public Dut {
+#endif
+
+#include "Dut.h"
+
+#define _TOP_NAME(t)    #t
+#define TOP_NAME(t)     _TOP_NAME(t)
+
+// TOP is final so the calls to clk_tick/trace/difftest/check in the run loop are not dispatched virtually
+class TOP final: public Dut {
 
 private:
     VTOP *top;
     int reset_cycle = 10;
+    bool done = false;      // the instruction in the commit stage is committed at the next posedge
 
 public:
     TOP(int argc, char *argv[], const test_info *info);
@@ -49,7 +90,13 @@ public:
     virtual void reset();
     virtual void clk_tick();
     virtual bool run(uint64_t step);
+    virtual void set_reset_vector(word_t pc);
+#ifdef CONFIG_CHECKPOINT
+    virtual void save_model(VerilatedSave &os);
+    virtual void restore_model(VerilatedRestore &os);
+#endif
     virtual word_t reg_id2val(int id);
+    virtual uint64_t perf_counter(int id);
 };
 
 #endif
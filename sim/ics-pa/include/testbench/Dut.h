@@ -16,41 +16,111 @@
 #ifndef __DUT_H__
 #define __DUT_H__
 
+#include <time.h>
 #include <verilated.h>
-#include <verilated_vcd_c.h>
 #include "common.h"
 #include "config.h"
+#ifdef CONFIG_WAVE
+#include <verilated_fst_c.h>
+#endif
+#ifdef CONFIG_CHECKPOINT
+#include <verilated_save.h>
+#endif
+
+// Performance counters in the design
+enum perf_counter_id {
+    PERF_CYCLE,         // mcycle
+    PERF_INSTRET,       // minstret
+    PERF_IFU_WAIT,      // mhpmcounter3: IFU waiting for instruction
+    PERF_LOAD_WAIT,     // mhpmcounter4: LSU waiting for load data
+    PERF_STORE_WAIT,    // mhpmcounter5: LSU waiting for store response
+    PERF_MULDIV_BUSY,   // mhpmcounter6: MulDiv busy
+    PERF_BUS_STALL,     // mhpmcounter7: bus request blocked by the arbiter
+    PERF_ICACHE_HIT,    // mhpmcounter8: instruction cache hit
+    PERF_ICACHE_MISS,   // mhpmcounter9: instruction cache miss
+    PERF_DCACHE_HIT,    // mhpmcounter10: data cache hit
+    PERF_DCACHE_MISS,   // mhpmcounter11: data cache miss
+    PERF_DCACHE_WB,     // mhpmcounter12: data cache dirty line write back
+    PERF_BRANCH,        // mhpmcounter13: branch/jump executed
+    PERF_MISPREDICT,    // mhpmcounter14: branch/jump mispredicted
+    NUM_PERF_COUNTER
+};
 
 class Dut {
 
 public:
-    VerilatedVcdC *m_trace;     // Waveform trace
     vluint64_t sim_time;        // simulation time
     word_t regs[NUM_REG];
     const test_info *info;
     bool finished;
     bool pass;
+    struct timespec run_begin;  // host time when run started
+    double run_second;          // host time spent in run
+    uint64_t next_ckpt;         // cycle of the next auto checkpoint
 
     Dut(int argc, char *argv[], const test_info *info);
     ~Dut();
 
+#ifdef CONFIG_WAVE
+    // waveform
+    VerilatedFstC *m_trace;     // Waveform trace
+    const char *wave_name;
+    int wave_state;
+    bool wave_on;               // dumping the waveform
+    vluint64_t wave_next;       // sim_time of the next waveform state change
+    int wave_seg;               // current segment file in ring mode
+    word_t wave_pc;             // PC trigger
+    word_t wave_mmio;           // MMIO address trigger
+    bool wave_difftest;         // difftest failure trigger
+
+    void wave_init(const char *name);
+    void wave_update();
+    void wave_open(const char *name);
+    void wave_trigger(const char *why);
+#endif
+
     virtual void init_trace(const char *name, int level)=0;
-    void dump();
+
+    /**
+     * Dump the waveform. Called every half cycle
+     */
+    inline void dump() {
+    #ifdef CONFIG_WAVE
+        if (unlikely(sim_time >= wave_next)) wave_update();
+        if (wave_on) m_trace->dump(sim_time);
+    #endif
+    }
 
     // common simulation task
     virtual void reset()=0;
     virtual void clk_tick()=0;
     virtual bool run(uint64_t step)=0;
+    virtual void set_reset_vector(word_t pc)=0;
     virtual void trace(word_t pc, word_t nxtpc, word_t inst);
-    virtual void difftest(word_t pc);
+    virtual void difftest(word_t pc, word_t inst);
     virtual void check();
     virtual bool report();
+    void run_start();
+    void run_stop();
+
+#ifdef CONFIG_CHECKPOINT
+    // checkpoint
+    void save(const char *name);
+    void restore(const char *name);
+    void auto_checkpoint();
+    virtual void save_model(VerilatedSave &os)=0;
+    virtual void restore_model(VerilatedRestore &os)=0;
+#endif
 
     // register access function
     virtual word_t reg_str2val(const char *s);
     virtual word_t reg_id2val(int id)=0;
     void read_reg();
     void report_reg();
+
+    // performance counter
+    virtual uint64_t perf_counter(int id)=0;
+    void report_perf();
 };
 
 #endif
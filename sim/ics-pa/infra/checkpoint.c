@@ -0,0 +1,99 @@
+// ------------------------------------------------------------------------------------------------
+// Copyright (c) 2023. Heqing Huang (feipenghhq@gmail.com)
+//
+// Project: NRC
+// Author: Heqing Huang
+// Date Created: 10/18/2026
+//
+// ------------------------------------------------------------------------------------------------
+// Checkpoint: save and restore the C side simulation state
+// ------------------------------------------------------------------------------------------------
+// The C side state is written to the same file after the verilator model:
+// guest memory, mmio space, device state and the difftest reference state.
+// Large memory is saved sparsely: only the pages that are not all zero are written.
+// ------------------------------------------------------------------------------------------------
+
+#include "checkpoint.h"
+
+#ifdef CONFIG_CHECKPOINT
+
+// ----------------------------------------------
+// Function prototype
+// ----------------------------------------------
+
+void pmem_save(ckpt_t *c);
+void pmem_restore(ckpt_t *c);
+void mmio_save(ckpt_t *c);
+void mmio_restore(ckpt_t *c);
+void device_save(ckpt_t *c);
+void device_restore(ckpt_t *c);
+void difftest_save(ckpt_t *c);
+void difftest_restore(ckpt_t *c);
+
+#define CKPT_PAGE_SIZE  4096
+#define CKPT_PAGE_END   ((uint64_t) -1)
+
+// ----------------------------------------------
+// Function
+// ----------------------------------------------
+
+static bool page_is_zero(const byte_t *page) {
+    const uint64_t *p = (const uint64_t *) page;
+    for (int i = 0; i < CKPT_PAGE_SIZE / sizeof(uint64_t); i++) {
+        if (p[i]) return false;
+    }
+    return true;
+}
+
+/**
+ * Write the non-zero pages of the memory: (page offset, page data) ... CKPT_PAGE_END
+ */
+void ckpt_write_pages(ckpt_t *c, const byte_t *base, size_t size) {
+    for (uint64_t off = 0; off < size; off += CKPT_PAGE_SIZE) {
+        if (page_is_zero(base + off)) continue;
+        ckpt_write_var(c, off);
+        ckpt_write(c, base + off, CKPT_PAGE_SIZE);
+    }
+    uint64_t end = CKPT_PAGE_END;
+    ckpt_write_var(c, end);
+}
+
+/**
+ * Read the pages written by ckpt_write_pages. The memory should be cleared by the caller
+ */
+void ckpt_read_pages(ckpt_t *c, byte_t *base, size_t size) {
+    uint64_t off;
+    while (1) {
+        ckpt_read_var(c, off);
+        if (off == CKPT_PAGE_END) break;
+        Check(off + CKPT_PAGE_SIZE <= size, "Invalid page offset 0x%lx in checkpoint", off);
+        ckpt_read(c, base + off, CKPT_PAGE_SIZE);
+    }
+}
+
+void ckpt_save_state(ckpt_t *c) {
+    pmem_save(c);
+#ifdef CONFIG_HAS_DEVICE
+    mmio_save(c);
+    device_save(c);
+#endif
+#ifdef CONFIG_DIFFTEST
+    difftest_save(c);
+#endif
+}
+
+void ckpt_restore_state(ckpt_t *c) {
+    pmem_restore(c);
+#ifdef CONFIG_HAS_DEVICE
+    mmio_restore(c);
+    device_restore(c);
+#endif
+#ifdef CONFIG_DIFFTEST
+    difftest_restore(c);
+#endif
+}
+
+#undef CKPT_PAGE_SIZE
+#undef CKPT_PAGE_END
+
+#endif
@@ -9,8 +9,10 @@
 // ------------------------------------------------------------------------------------------------
 
 #include <dlfcn.h>
+#include <sys/mman.h>
 #include "common.h"
 #include "config.h"
+#include "checkpoint.h"
 
 #ifdef CONFIG_DIFFTEST
 
@@ -21,7 +23,8 @@
 #define CONFIG_DIFFTEST_VERBOSE
 
 byte_t *mem_ptr();
-void init_ref(size_t mem_size);
+extern size_t pmem_size;
+void init_ref(size_t mem_size, word_t entry);
 const char *reg_id2str(int id);
 
 static void *lib = NULL;
@@ -38,6 +41,44 @@ static difftest_init_t   difftest_init;
 static difftest_memcpy_t difftest_memcpy;
 static difftest_exec_t   difftest_exec;
 static difftest_regcpy_t difftest_regcpy;
+
+#if CONFIG_DIFFTEST_BATCH > 1
+
+// In batch mode, the DUT state of each committed instruction is logged. The reference model
+// runs the whole batch in one call and the state is only compared at the end of the batch.
+// On mismatch, the reference model is rolled back to the last good checkpoint and the batch
+// is replayed one instruction at a time to find the first bad instruction.
+
+// DUT state after an instruction is committed
+typedef struct commit_log {
+    word_t reg[NUM_REG];
+    word_t pc;
+    bool skip;          // skip the instruction in reference model (mmio access)
+} commit_log;
+
+// memory write of the store instructions in the batch. Used to roll back the reference memory.
+// The data is read from the reference memory when the store is committed. The reference model has
+// not run the batch yet so it is the data before the write. The guest memory can not be used as the
+// DCache writes the data back to it at a different time.
+typedef struct store_log {
+    word_t addr;
+    word_t data;        // data before the write
+} store_log;
+
+// A misaligned store writes 2 words
+#define MAX_STORE       (CONFIG_DIFFTEST_BATCH * 2)
+
+static commit_log commits[CONFIG_DIFFTEST_BATCH];
+static store_log stores[MAX_STORE];
+static int nr_commit = 0;
+static int nr_store = 0;
+
+// last good checkpoint
+static word_t ckpt_reg[NUM_REG];
+static word_t ckpt_pc;
+
+#endif
+
 // ------------------------------------
 // Functions
 // ------------------------------------
@@ -46,24 +87,35 @@ static difftest_regcpy_t difftest_regcpy;
     name = (name##_t) dlsym(lib, #name); \
     Check(name, "Failed to load from shared lib")
 
-void init_difftest(char *ref, size_t mem_size) {
+void init_difftest(char *ref, size_t mem_size, word_t entry) {
     lib = dlopen(ref, RTLD_NOW);
     Check(lib, "Failed to open shared lib: %s. %s.", ref, dlerror());
     load_from_so(difftest_init);
     load_from_so(difftest_memcpy);
     load_from_so(difftest_exec);
     load_from_so(difftest_regcpy);
-    init_ref(mem_size);
+    init_ref(mem_size, entry);
 }
 
 
 /**
  * initialize the reference model
  */
-void init_ref(size_t mem_size) {
+void init_ref(size_t mem_size, word_t entry) {
+    word_t reg[NUM_REG];
+    word_t pc;
     difftest_init(0);
     difftest_memcpy(MEM_BASE, mem_ptr(), mem_size, DIFFTEST_TO_REF);
+    // start the reference model from the entry point of the program
+    difftest_regcpy(reg, &pc, DIFFTEST_TO_DUT);
+    pc = entry;
+    difftest_regcpy(reg, &pc, DIFFTEST_TO_REF);
+#if CONFIG_DIFFTEST_BATCH > 1
+    difftest_regcpy(ckpt_reg, &ckpt_pc, DIFFTEST_TO_DUT);
+    log_info("Initialized difftest. Batch size: %d", CONFIG_DIFFTEST_BATCH);
+#else
     log_info("Initialized difftest");
+#endif
 }
 
 /**
@@ -89,23 +141,25 @@ void ref_exec(uint64_t n, word_t *dut_reg, word_t *dut_pc) {
 }
 
 /**
- * Compare the result between dut and ref
- * @param dut_pc: the DUT PC value of the next instruction (because we have already completed this instruction)
+ * Compare the register and pc between dut and ref
  */
-bool difftest_compare(word_t *dut_reg, word_t dut_pc ) {
+static bool compare(word_t *dut_reg, word_t dut_pc, bool verbose) {
     bool pass = true;
     word_t ref_reg[NUM_REG];
     word_t ref_pc;
     difftest_regcpy(ref_reg, &ref_pc, DIFFTEST_TO_DUT);
     // make sure that the pc of the instruction being compared is the same
     if (ref_pc != dut_pc) {
-        log_err("difftest: PC of the compared instruction mismatch. Ref: 0x%08x. Dut: 0x%08x",
-                ref_pc, dut_pc);
+        if (verbose) {
+            log_err("difftest: PC of the compared instruction mismatch. Ref: 0x%08x. Dut: 0x%08x",
+                    ref_pc, dut_pc);
+        }
         return false;
     }
     // make sure register is the same
     for (int i = 0; i < NUM_REG; i++) {
       if (ref_reg[i] != dut_reg[i]) {
+        if (!verbose) return false;
         log_err("difftest: Register Value mismatch after executing instruction before PC: 0x%08x. "
                 "Reg %s ($%d). Ref: 0x%08x. Dut: 0x%08x",
                 dut_pc, reg_id2str(i), i, ref_reg[i], dut_reg[i]);
@@ -116,4 +170,192 @@ bool difftest_compare(word_t *dut_reg, word_t dut_pc ) {
     return pass;
 }
 
+/**
+ * Compare the result between dut and ref
+ * @param dut_pc: the DUT PC value of the next instruction (because we have already completed this instruction)
+ */
+bool difftest_compare(word_t *dut_reg, word_t dut_pc) {
+    return compare(dut_reg, dut_pc, true);
+}
+
+#if CONFIG_DIFFTEST_BATCH > 1
+
+/**
+ * Get the address written by a store instruction (RV32I and RV32C)
+ * Return the number of bytes written. 0 if it is not a store
+ * @param reg: the register value before the instruction
+ */
+static int store_addr(word_t inst, const word_t *reg, word_t *addr) {
+    if ((inst & 0x7f) == 0x23) {                    // sb/sh/sw
+        word_t imm = (word_t) ((int32_t) (inst & 0xfe000000) >> 20) | ((inst >> 7) & 0x1f);
+        *addr = reg[(inst >> 15) & 0x1f] + imm;
+        return 1 << ((inst >> 12) & 0x3);
+    }
+    switch (inst & 0xe003) {
+        case 0xc000:                                // c.sw
+            *addr = reg[8 + ((inst >> 7) & 0x7)] + (((inst >> 7) & 0x38) | ((inst << 1) & 0x40) | ((inst >> 4) & 0x4));
+            return 4;
+        case 0xc002:                                // c.swsp
+            *addr = reg[2] + (((inst >> 7) & 0x3c) | ((inst >> 1) & 0xc0));
+            return 4;
+    }
+    return 0;
+}
+
+/**
+ * Log the reference memory words written by the store before the reference model runs it
+ */
+static void log_store(word_t addr, int size) {
+    word_t word = addr & ~0x3;
+    int n = ((addr & 0x3) + size + 3) / 4;
+    for (int i = 0; i < n; i++, word += 4) {
+        // a store out of the memory does not change the reference memory
+        if (word - MEM_BASE > pmem_size - sizeof(word_t)) continue;
+        stores[nr_store].addr = word;
+        difftest_memcpy(word, &stores[nr_store].data, sizeof(word_t), DIFFTEST_TO_DUT);
+        nr_store++;
+    }
+}
+
+/**
+ * Roll back the reference model to the last checkpoint and replay the batch one instruction at a time
+ */
+static bool replay_batch() {
+    log_warn("difftest: mismatch found in the batch. Replay the batch from checkpoint at PC: 0x%08x", ckpt_pc);
+    for (int i = nr_store - 1; i >= 0; i--) {
+        difftest_memcpy(stores[i].addr, &stores[i].data, sizeof(word_t), DIFFTEST_TO_REF);
+    }
+    difftest_regcpy(ckpt_reg, &ckpt_pc, DIFFTEST_TO_REF);
+    for (int i = 0; i < nr_commit; i++) {
+        commit_log *c = &commits[i];
+        if (c->skip) {
+            difftest_regcpy(c->reg, &c->pc, DIFFTEST_TO_REF);
+        }
+        else {
+            difftest_exec(1);
+        }
+        if (!compare(c->reg, c->pc, true)) {
+            return false;
+        }
+    }
+    log_err("difftest: mismatch is not reproduced when replaying the batch one instruction at a time");
+    return false;
+}
+
+/**
+ * Run the reference model for all the instructions in the batch and compare the final state
+ */
+bool difftest_flush() {
+    if (nr_commit == 0) return true;
+    // instruction accessing mmio is not executed in reference model, the DUT state is copied instead
+    int n = 0;
+    for (int i = 0; i < nr_commit; i++) {
+        if (commits[i].skip) {
+            if (n) difftest_exec(n);
+            difftest_regcpy(commits[i].reg, &commits[i].pc, DIFFTEST_TO_REF);
+            n = 0;
+        }
+        else {
+            n++;
+        }
+    }
+    if (n) difftest_exec(n);
+
+    commit_log *last = &commits[nr_commit - 1];
+    bool pass = compare(last->reg, last->pc, false);
+    if (pass) {
+        memcpy(ckpt_reg, last->reg, sizeof(ckpt_reg));
+        ckpt_pc = last->pc;
+    }
+    else {
+        pass = replay_batch();
+    }
+    nr_commit = 0;
+    nr_store = 0;
+    return pass;
+}
+
+/**
+ * Log the DUT state of a committed instruction and run the batch when it is full
+ * @param inst: the committed instruction. Used to log the memory written by the store
+ */
+bool difftest_step(word_t *dut_reg, word_t dut_pc, word_t inst) {
+    commit_log *c = &commits[nr_commit];
+    c->skip = is_skip_ref;
+    is_skip_ref = false;
+    // the store to mmio is not run by the reference model
+    if (!c->skip) {
+        word_t addr;
+        int size = store_addr(inst, nr_commit ? commits[nr_commit - 1].reg : ckpt_reg, &addr);
+        if (size) log_store(addr, size);
+    }
+    memcpy(c->reg, dut_reg, sizeof(c->reg));
+    c->pc = dut_pc;
+    nr_commit++;
+    if (nr_commit < CONFIG_DIFFTEST_BATCH) return true;
+    return difftest_flush();
+}
+
+#endif
+
+#ifdef CONFIG_CHECKPOINT
+
+// The checkpoint is only taken on instruction boundary and the batch has been flushed so
+// the reference model is in sync with the DUT. The reference memory is saved as well because
+// the guest memory does not have the dirty lines held in the DCache. The skip flag is saved as
+// the mmio access can happen before the instruction is committed.
+
+// buffer for the reference memory. Only the touched pages take host memory
+static byte_t *ref_mem_alloc() {
+    void *buf = mmap(NULL, pmem_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    Check(buf != MAP_FAILED, "difftest: failed to allocate the reference memory buffer");
+    return (byte_t *) buf;
+}
+
+void difftest_save(ckpt_t *c) {
+    word_t reg[NUM_REG];
+    word_t pc;
+    bool has_ref = lib != NULL;
+    ckpt_write_var(c, has_ref);
+    if (!has_ref) return;
+#if CONFIG_DIFFTEST_BATCH > 1
+    Check(nr_commit == 0, "difftest: batch is not flushed before checkpoint");
+#endif
+    difftest_regcpy(reg, &pc, DIFFTEST_TO_DUT);
+    ckpt_write_var(c, reg);
+    ckpt_write_var(c, pc);
+    ckpt_write_var(c, is_skip_ref);
+    byte_t *buf = ref_mem_alloc();
+    difftest_memcpy(MEM_BASE, buf, pmem_size, DIFFTEST_TO_DUT);
+    ckpt_write_pages(c, buf, pmem_size);
+    munmap(buf, pmem_size);
+}
+
+void difftest_restore(ckpt_t *c) {
+    word_t reg[NUM_REG];
+    word_t pc;
+    bool has_ref;
+    ckpt_read_var(c, has_ref);
+    Check(has_ref || !lib, "difftest: the checkpoint is saved without the reference model");
+    if (!has_ref) return;
+    ckpt_read_var(c, reg);
+    ckpt_read_var(c, pc);
+    ckpt_read_var(c, is_skip_ref);
+    byte_t *buf = ref_mem_alloc();
+    ckpt_read_pages(c, buf, pmem_size);
+    if (lib) {
+        difftest_memcpy(MEM_BASE, buf, pmem_size, DIFFTEST_TO_REF);
+        difftest_regcpy(reg, &pc, DIFFTEST_TO_REF);
+    #if CONFIG_DIFFTEST_BATCH > 1
+        memcpy(ckpt_reg, reg, sizeof(ckpt_reg));
+        ckpt_pc = pc;
+        nr_commit = 0;
+        nr_store = 0;
+    #endif
+    }
+    munmap(buf, pmem_size);
+}
+
+#endif
+
 #endif
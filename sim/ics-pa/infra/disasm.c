@@ -19,8 +19,9 @@
 #include <stdio.h>
 #include "common.h"
 #include "config.h"
+#include "itrace.h"
 
-#ifdef CONFIG_ITRACE
+// Built without CONFIG_ITRACE as well. It is shared by itrace and the itrace-decode tool
 
 #define INST_LEN 33
 
@@ -33,11 +34,12 @@ void init_disasm() {
     LLVMInitializeAllTargetMCs();
     LLVMInitializeAllAsmParsers();
     LLVMInitializeAllDisassemblers();
-    dc = LLVMCreateDisasm("riscv64", NULL, 0, NULL, NULL);
+    // RV32 target with M and C extension so the compressed instructions are decoded as RV32C
+    dc = LLVMCreateDisasmCPUFeatures("riscv32", "", "+m,+c", NULL, 0, NULL, NULL);
 }
 
 char *disasm(word_t *inst, word_t pc) {
-    size_t rc = LLVMDisasmInstruction(dc, (uint8_t*) inst, 4, pc, instbuf, INST_LEN);
+    size_t rc = LLVMDisasmInstruction(dc, (uint8_t*) inst, INST_SIZE(*inst), pc, instbuf, INST_LEN);
     //Check(rc, "Failed to disassemble instruction 0x%08x", *inst);
     if (!rc) {
         strcpy(instbuf, unknow);
@@ -46,5 +48,3 @@ char *disasm(word_t *inst, word_t pc) {
 }
 
 #undef INST_LEN
-
-#endif
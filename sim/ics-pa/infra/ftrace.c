@@ -11,11 +11,9 @@
 #include <elf.h>
 #include <stdio.h>
 #include <stdlib.h>
-#include <sys/stat.h>
-#include <fcntl.h>
-#include <sys/mman.h>
 #include <assert.h>
 #include "ftrace.h"
+#include "loader.h"
 
 #ifdef CONFIG_FTRACE
 
@@ -25,52 +23,105 @@
 #define JAL           0x6F
 #define JALR          0x67
 
-#define MSG_LEN       CONFIG_FRINGBUF_SIZE
+// RV32C: c.jal, c.jalr and c.jr. The register field of c.jalr/c.jr is inst[11:7]
+#define IS_RVC(inst)  (((inst) & 0x3) != 0x3)
+#define C_JAL(inst)   (((inst) & 0xE003) == 0x2001)
+#define C_JALR(inst)  (((inst) & 0xF07F) == 0x9002 && RD(inst) != 0)
+#define C_JR(inst)    (((inst) & 0xF07F) == 0x8002 && RD(inst) != 0)
+
+#define FTRACE_CALL   0x1
 
 ;
 
-// use a linked list data structure to store the function information
+// function symbol. All the symbols are stored in an array sorted by the start address
 struct func_info {
     uint32_t start;
     uint32_t end;
     char *name;
-    struct func_info *next;
 };
 
-extern FILE *ftrace_fp;
 static ringbuf *rb = NULL;
+#ifdef CONFIG_FTRACE_WRITE_LOG
+static tsink *sink = NULL;
+#endif
 static int level = 0;
 static char unknow[] = "???";
-static struct func_info *start = NULL;
+static struct func_info *funcs = NULL;
+static int nr_func = 0;
+static int max_func = 0;
+static __thread struct func_info *last_hit = NULL;   // cache the last lookup result (per thread)
 
-static void find_func_info(const char *);
+static void find_func_info(const char *, word_t);
 void print_func_info();
+char *find_func_name(word_t addr);
+
+/**
+ * Format one function trace record. The target address is in addr and the call level is in data
+ */
+static void ftrace_format(const trace_rec *rec, char *msg, int size) {
+    int indent = (int) rec->data > 0 ? (int) rec->data * 2 : 0;
+    snprintf(msg, size, "0x%x: %*s%s [%s@0x%x]", rec->pc, indent, "",
+             (rec->flags & FTRACE_CALL) ? "call" : "ret", find_func_name(rec->addr), rec->addr);
+}
 
+static int func_cmp(const void *a, const void *b) {
+    const struct func_info *fa = (const struct func_info *) a;
+    const struct func_info *fb = (const struct func_info *) b;
+    return (fa->start > fb->start) - (fa->start < fb->start);
+}
+
+/**
+ * Read the function symbols from elf files. Multiple elf files (kernel and the loaded apps)
+ * are separated by ',' and each elf can be followed by its load base address: elf[@base]
+ */
 void ftrace_init(const char *elf) {
-  find_func_info(elf);
-  rb = ringbuf_create(CONFIG_FRINGBUF_ENTRY, CONFIG_FRINGBUF_SIZE);
+    Check(elf, "Please specify the ELF file for ftrace");
+    char *list = strdup(elf);
+    CheckMalloc(list);
+    char *save = NULL;
+    for (char *tok = strtok_r(list, ",", &save); tok; tok = strtok_r(NULL, ",", &save)) {
+        word_t base = 0;
+        char *at = strchr(tok, '@');
+        if (at) {
+            *at = '\0';
+            base = strtoul(at + 1, NULL, 0);
+        }
+        find_func_info(tok, base);
+    }
+    free(list);
+    qsort(funcs, nr_func, sizeof(struct func_info), func_cmp);
+    log_info("Found %d functions for ftrace.", nr_func);
+    rb = ringbuf_create(CONFIG_FRINGBUF_ENTRY, CONFIG_FRINGBUF_SIZE, ftrace_format);
+#ifdef CONFIG_FTRACE_WRITE_LOG
+    sink = tsink_open("ftrace.log", NULL, ftrace_format, CONFIG_FRINGBUF_SIZE, NULL);
+#endif
 }
 
 void ftrace_close() {
     ringbuf_delete(rb);
+    free(funcs);
+}
+
+static void add_func(uint32_t start, uint32_t size, char *name) {
+    if (nr_func == max_func) {
+        max_func = max_func ? max_func * 2 : 1024;
+        funcs = (struct func_info *) realloc(funcs, max_func * sizeof(struct func_info));
+        CheckMalloc(funcs);
+    }
+    funcs[nr_func].start = start;
+    funcs[nr_func].end = start + size;
+    funcs[nr_func].name = name;
+    nr_func++;
 }
 
 /**
  * find all the functions from elf file
  */
-static void find_func_info(const char *elf) {
-
-    log_info("Read ELF file for ftrace: %s.", elf);
-    // open the file and get the file size
-    struct stat statbuf;
-    int fd = open(elf, O_RDONLY);
-    Check(fd, "Can open file %s.\n", elf);
-    int rc = fstat(fd, &statbuf);
-    assert(rc == 0); // fstat return 0 if no error
+static void find_func_info(const char *elf, word_t base) {
 
-    // map the file to memory
-    char *addr = (char *) mmap(NULL, statbuf.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
-    Check(addr, "mmap failed to map elf file into memory");
+    log_info("Read ELF file for ftrace: %s. Base: 0x%08x", elf, base);
+    // the mapping is kept by the loader so the function name can point into it
+    char *addr = (char *) elf_open(elf);
 
     // read the elf header
     Elf32_Ehdr *elf32_hdr;
@@ -96,27 +147,21 @@ static void find_func_info(const char *elf) {
     Check(sym_shdr, "Failed to find symbol table in ELF file %s", elf);
     Check(str_shdr, "Failed to find symbol string table in ELF file %s", elf);
 
-    // get all function in the symbol table
+    // get all function in the symbol table.
+    // function with zero size never matches any address so it is not added
     size_t num_symbol = sym_shdr-> sh_size / sym_shdr -> sh_entsize;
     for (int i = 0; i < num_symbol; i++) {
         Elf32_Sym *sym = ((Elf32_Sym *) (addr + sym_shdr->sh_offset)) + i;
-        if (ELF32_ST_TYPE(sym->st_info) == STT_FUNC) {
+        if (ELF32_ST_TYPE(sym->st_info) == STT_FUNC && sym->st_size) {
             char *name = ((char *) (addr + str_shdr->sh_offset)) + sym->st_name;
-            struct func_info *node = (struct func_info *) malloc(sizeof(struct func_info));
-            assert(node);
-            node->start = sym->st_value;
-            node->end = sym->st_value + sym->st_size;
-            node->name = name;
-            node->next = start; // insert to the front of the list
-            start = node;
+            add_func(sym->st_value + base, sym->st_size, name);
         }
     }
 }
 
 void print_func_info() {
-    struct func_info *s = start;
-    for (; s != NULL; s = s->next) {
-        Log("[0x%08x, 0x%08x): %s\n", s->start, s->end, s->name);
+    for (int i = 0; i < nr_func; i++) {
+        Log("[0x%08x, 0x%08x): %s\n", funcs[i].start, funcs[i].end, funcs[i].name);
     }
 }
 
@@ -124,56 +169,63 @@ void print_func_info() {
  * find function name given its address
  */
 char *find_func_name(word_t addr) {
-  struct func_info *s = start;
-  for (; s != NULL; s = s->next) {
-    if (addr >= s->start && addr < s->end) {
-      return s->name;
+  if (last_hit && addr >= last_hit->start && addr < last_hit->end) {
+    return last_hit->name;
+  }
+  // binary search for the last function whose start address <= addr
+  int lo = 0, hi = nr_func - 1, idx = -1;
+  while (lo <= hi) {
+    int mid = lo + (hi - lo) / 2;
+    if (funcs[mid].start <= addr) {
+      idx = mid;
+      lo = mid + 1;
     }
+    else {
+      hi = mid - 1;
+    }
+  }
+  if (idx >= 0 && addr < funcs[idx].end) {
+    last_hit = &funcs[idx];
+    return last_hit->name;
   }
   return unknow;
 }
 
-// Function call instruction: jal ra label or jalr ra rd imm
+// Function call instruction: jal ra label or jalr ra rd imm. c.jal and c.jalr always link to ra
 static bool is_func_call(word_t inst) {
+  if (IS_RVC(inst)) return C_JAL(inst) || C_JALR(inst);
   unsigned char opcode = OPCODE(inst);
   unsigned char rd = RD(inst);
   return (rd == 1) && ((opcode == JAL) || (opcode == JALR));
 }
 
-// Function return is ret instruction which is jalr x0, 0(x1)
+// Function return is ret instruction which is jalr x0, 0(x1) or c.jr x1
 static bool is_func_ret(word_t inst) {
+  if (IS_RVC(inst)) return C_JR(inst) && RD(inst) == 1;
   unsigned char opcode = OPCODE(inst);
   unsigned char rd = RD(inst);
   unsigned char rs1 = RS1(inst);
   return (rd == 0) && (rs1 == 1) && (opcode == JALR);
 }
 
+static void trace_func_log(word_t pc, word_t nxtpc, uint8_t flags) {
+  trace_rec rec = {.pc = pc, .addr = nxtpc, .data = (word_t) level, .flags = flags, .cycle = sim_cycle()};
+  ringbuf_write(rb, &rec);
+  #ifdef CONFIG_FTRACE_WRITE_LOG
+      tsink_write(sink, &rec);
+  #endif
+}
+
 static void trace_func_call(word_t pc, word_t nxtpc, word_t inst)  {
-  char msg[MSG_LEN];
   if (is_func_call(inst)) {
-    int cnt = snprintf(msg, MSG_LEN, "0x%x: ", pc);
-    for (int i = 0; i < level; i++) cnt += snprintf(msg + cnt, MSG_LEN, "  ");
-    snprintf(msg + cnt, MSG_LEN, "call [%s@0x%x]", find_func_name(nxtpc), nxtpc);
-    #ifdef CONFIG_FTRACE_WRITE_LOG
-        fprintf(ftrace_fp, "%s\n", msg);
-        fflush(ftrace_fp);
-    #endif
-    ringbuf_write(rb, msg);
+    trace_func_log(pc, nxtpc, FTRACE_CALL);
     level++;
   }
 }
 
 static void trace_func_ret(word_t pc, word_t nxtpc, word_t inst)  {
-  char msg[MSG_LEN];
   if (is_func_ret(inst)) {
-    int cnt = snprintf(msg, MSG_LEN, "0x%x: ", pc);
-    for (int i = 0; i < level; i++) cnt += snprintf(msg + cnt, MSG_LEN - cnt, "  ");
-    cnt += snprintf(msg + cnt, MSG_LEN - cnt, "ret [%s@0x%x]", find_func_name(nxtpc), nxtpc);
-    #ifdef CONFIG_FTRACE_WRITE_LOG
-        fprintf(ftrace_fp, "%s\n", msg);
-        fflush(ftrace_fp);
-    #endif
-    ringbuf_write(rb, msg);
+    trace_func_log(pc, nxtpc, 0);
     level--;
   }
 }
@@ -193,7 +245,10 @@ void ftrace_print() {
 #undef RS1
 #undef JAL
 #undef JALR
-
-#undef MSG_LEN
+#undef IS_RVC
+#undef C_JAL
+#undef C_JALR
+#undef C_JR
+#undef FTRACE_CALL
 
 #endif
@@ -7,6 +7,10 @@
 // ------------------------------------------------------------------------------------------------
 // Itrace: Instruction trace
 // ------------------------------------------------------------------------------------------------
+// Only the raw (pc, inst) pair is recorded for each instruction. The instruction is disassembled
+// lazily when the ring buffer is dumped. The log file is a binary file and can be decoded offline
+// with the itrace-decode tool.
+// ------------------------------------------------------------------------------------------------
 
 #include <string.h>
 #include "itrace.h"
@@ -18,19 +22,37 @@
 // ----------------------------------------------
 
 void init_disasm();
-extern FILE *itrace_fp;
 char *disasm(word_t *inst, word_t pc);
+
 static ringbuf *rb = NULL;
+static bool disasm_ready = false;
+
+#define LOG_NAME "itrace.bin"
 
-#define MSG_LEN  CONFIG_IRINGBUF_SIZE
+#ifdef CONFIG_ITRACE_WRITE_LOG
+static tsink *sink = NULL;
+#endif
 
 // ----------------------------------------------
 // Instruction Trace
 // ----------------------------------------------
 
+static void itrace_format(const trace_rec *rec, char *msg, int size);
+
+/**
+ * Encode one record into the binary log
+ */
+static int itrace_encode(const trace_rec *rec, char *buf, int size) {
+    itrace_rec log = {.pc = rec->pc, .inst = rec->inst};
+    memcpy(buf, &log, sizeof(itrace_rec));
+    return sizeof(itrace_rec);
+}
+
 void itrace_init() {
-    rb = ringbuf_create(CONFIG_IRINGBUF_ENTRY, CONFIG_IRINGBUF_SIZE);
-    init_disasm();
+    rb = ringbuf_create(CONFIG_IRINGBUF_ENTRY, CONFIG_IRINGBUF_SIZE, itrace_format);
+#ifdef CONFIG_ITRACE_WRITE_LOG
+    sink = tsink_open(LOG_NAME, ITRACE_MAGIC, itrace_format, CONFIG_IRINGBUF_SIZE, itrace_encode);
+#endif
 }
 
 void itrace_close() {
@@ -38,22 +60,35 @@ void itrace_close() {
 }
 
 void itrace_write(word_t pc, word_t inst) {
-    char msg[MSG_LEN];
-    snprintf(msg, MSG_LEN, "0x%08x: 0x%08x%s", pc, inst, disasm(&inst, pc));
+    trace_rec rec = {.pc = pc, .inst = inst, .cycle = sim_cycle()};
+    ringbuf_write(rb, &rec);
 #ifdef CONFIG_ITRACE_WRITE_LOG
-    fprintf(itrace_fp, "%s\n", msg);
-    fflush(itrace_fp);
+    tsink_write(sink, &rec);
 #endif
-    ringbuf_write(rb, msg);
+}
+
+/**
+ * Format one instruction record
+ */
+static void itrace_format(const trace_rec *rec, char *msg, int size) {
+    word_t inst = rec->inst;
+    if (INST_SIZE(inst) == 4)
+        snprintf(msg, size, "0x%08x: 0x%08x%s", rec->pc, inst, disasm(&inst, rec->pc));
+    else
+        snprintf(msg, size, "0x%08x: 0x%04x    %s", rec->pc, inst, disasm(&inst, rec->pc));
 }
 
 void itrace_print() {
     Log("Instruction sequence to error instruction (Dump from iringbuf):\n");
     Log("     PC          MCode          Instruction\n");
     Log("     ----------- ----------     -----------\n");
+    if (!disasm_ready) {
+        init_disasm();
+        disasm_ready = true;
+    }
     ringbuf_print(rb);
 }
 
-#undef MSG_LEN
+#undef LOG_NAME
 
 #endif
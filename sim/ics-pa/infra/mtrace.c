@@ -12,14 +12,25 @@
 
 #ifdef CONFIG_MTRACE
 
-#define MSG_LEN CONFIG_MRINGBUF_SIZE
-
-extern FILE *mtrace_fp;
 extern word_t dpi_mem_access_pc;
 static ringbuf *rb = NULL;
+#ifdef CONFIG_MTRACE_WRITE_LOG
+static tsink *sink = NULL;
+#endif
+
+#define MTRACE_WRITE 0x1
+
+static void mtrace_format(const trace_rec *rec, char *msg, int size) {
+    snprintf(msg, size, "%s: at addr: 0x%08x. data: 0x%08x. strb: 0x%x (@0x%08x, cycle %lu)",
+            (rec->flags & MTRACE_WRITE) ? "write" : " read", rec->addr, rec->data, rec->strb,
+            rec->pc, rec->cycle);
+}
 
 void mtrace_init() {
-    rb = ringbuf_create(CONFIG_MRINGBUF_ENTRY, CONFIG_MRINGBUF_SIZE);
+    rb = ringbuf_create(CONFIG_MRINGBUF_ENTRY, CONFIG_MRINGBUF_SIZE, mtrace_format);
+#ifdef CONFIG_MTRACE_WRITE_LOG
+    sink = tsink_open("mtrace.log", NULL, mtrace_format, CONFIG_MRINGBUF_SIZE, NULL);
+#endif
 }
 
 void mtrace_close() {
@@ -27,16 +38,14 @@ void mtrace_close() {
 }
 
 void mtrace_write(word_t addr, word_t data, word_t strb, bool is_write, bool ifetch) {
-    char msg[MSG_LEN];
     bool in_range = (addr >= CONFIG_MTRACE_START) && (addr <= CONFIG_MTRACE_END);
     if (!ifetch && in_range) {
-        snprintf(msg, MSG_LEN, "%s: at addr: 0x%08x. data: 0x%08x. strb: 0x%x (@0x%08x)",
-                is_write ? "write" : " read", addr, data, strb, dpi_mem_access_pc);
+        trace_rec rec = {.pc = dpi_mem_access_pc, .addr = addr, .data = data, .strb = strb,
+                         .flags = is_write ? MTRACE_WRITE : 0, .cycle = sim_cycle()};
+        ringbuf_write(rb, &rec);
     #ifdef CONFIG_MTRACE_WRITE_LOG
-        fprintf(mtrace_fp, "%s\n", msg);
-        fflush(mtrace_fp);
+        tsink_write(sink, &rec);
     #endif
-        ringbuf_write(rb, msg);
     }
 }
 
@@ -45,6 +54,6 @@ void mtrace_print() {
     ringbuf_print(rb);
 }
 
-#undef MSG_LEN
+#undef MTRACE_WRITE
 
 #endif
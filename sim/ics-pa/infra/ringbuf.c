@@ -16,56 +16,59 @@
 // Function
 // ----------------------------------------------
 
-ringbuf *ringbuf_create(int entry, int size) {
-    ringbuf *rb = (ringbuf *) malloc(sizeof(ringbuf));
+ringbuf *ringbuf_create(int entry, int size, ringbuf_fmt fmt) {
+    ringbuf *rb = (ringbuf *) aligned_alloc(CACHE_LINE, sizeof(ringbuf));
     CheckMalloc(rb);
+    memset(rb, 0, sizeof(ringbuf));
+    // round the entry up to power of 2 so the index is a simple mask
+    uint32_t n = 1;
+    while (n < entry) n <<= 1;
+    rb->entry = n;
+    rb->mask = n - 1;
     rb->size = size;
-    rb->entry = entry;
-    rb->head = entry - 1;
-    rb->node = (ringbuf_node *) malloc(entry * sizeof(ringbuf_node));
-    CheckMalloc(rb->node);
-    for (int i = 0; i < entry; i++) {
-        rb->node[i].buf = (char *) malloc(size * sizeof(char));
-        CheckMalloc(rb->node[i].buf);
-        rb->node[i].vld = false;
-    }
+    rb->fmt = fmt;
+    size_t bytes = (n * sizeof(trace_rec) + CACHE_LINE - 1) & ~(CACHE_LINE - 1);
+    rb->rec = (trace_rec *) aligned_alloc(CACHE_LINE, bytes);
+    CheckMalloc(rb->rec);
+    memset(rb->rec, 0, bytes);
     return rb;
 }
 
 void ringbuf_delete(ringbuf *rb) {
-    for (int i = 0; i < rb->entry; i++) {
-        free(rb->node[i].buf);
-    }
-    free(rb->node);
+    free(rb->rec);
     free(rb);
 }
 
-
-inline static void ringbuf_inc_wrap(ringbuf *rb) {
-    if (rb->head == (rb->entry - 1)) {
-        rb->head = 0;
-    }
-    else {
-        rb->head++;
+/**
+ * Read the oldest unread record from the ring buffer (consumer)
+ * Return false if there is no record to read
+ */
+bool ringbuf_read(ringbuf *rb, trace_rec *rec) {
+    while (1) {
+        uint64_t head = __atomic_load_n(&rb->head, __ATOMIC_ACQUIRE);
+        if (rb->tail == head) return false;
+        // The record has been overwritten by the producer, skip to the oldest one in the buffer.
+        // When the buffer is full, the next write goes to the tail slot so it is also skipped.
+        if (head - rb->tail >= rb->entry) {
+            rb->lost += head - rb->tail - rb->entry + 1;
+            rb->tail = head - rb->entry + 1;
+        }
+        *rec = rb->rec[rb->tail & rb->mask];
+        // check again in case the producer overwrites the record while we are copying it
+        head = __atomic_load_n(&rb->head, __ATOMIC_ACQUIRE);
+        if (head - rb->tail >= rb->entry) continue;
+        __atomic_store_n(&rb->tail, rb->tail + 1, __ATOMIC_RELEASE);
+        return true;
     }
 }
 
-void ringbuf_write(ringbuf *rb, char *str) {
-    ringbuf_inc_wrap(rb);
-    char *buf = rb->node[rb->head].buf;
-    char *rc = strcpy(buf, str);
-    Check(rc, "Failed to write to ringbuf");
-    rb->node[rb->head].vld = true;
-}
-
 void ringbuf_print(ringbuf *rb) {
-    int curr = rb->head == (rb->entry - 1) ? 0 : rb->head + 1; // point curr to the next location of head
-    for (; curr < rb->entry; curr++)
-        if (rb->node[curr].vld) Log("     %s\n", rb->node[curr].buf);
-    for (curr = 0; curr < rb->head; curr++)
-        if (rb->node[curr].vld) Log("     %s\n", rb->node[curr].buf);
-
-    Log("---> %s\n", rb->node[rb->head].buf);
+    char msg[rb->size];
+    uint64_t head = __atomic_load_n(&rb->head, __ATOMIC_ACQUIRE);
+    uint64_t num = head < rb->entry ? head : rb->entry;
+    for (uint64_t i = head - num; i < head; i++) {
+        rb->fmt(&rb->rec[i & rb->mask], msg, rb->size);
+        Log("%s %s\n", i == head - 1 ? "--->" : "    ", msg);
+    }
     Log("\n");
 }
-
@@ -11,13 +11,20 @@
 
 #ifdef CONFIG_STRACE
 
-#define MSG_LEN CONFIG_SRINGBUF_SIZE
-
-extern FILE *strace_fp;
 static ringbuf *rb = NULL;
+#ifdef CONFIG_STRACE_WRITE_LOG
+static tsink *sink = NULL;
+#endif
+
+static void strace_format(const trace_rec *rec, char *msg, int size) {
+    snprintf(msg, size, "[Strace]: System call 0x%08x @PC 0x%08x (cycle %lu)", rec->data, rec->pc, rec->cycle);
+}
 
 void strace_init() {
-    rb = ringbuf_create(CONFIG_SRINGBUF_ENTRY, CONFIG_SRINGBUF_SIZE);
+    rb = ringbuf_create(CONFIG_SRINGBUF_ENTRY, CONFIG_SRINGBUF_SIZE, strace_format);
+#ifdef CONFIG_STRACE_WRITE_LOG
+    sink = tsink_open("strace.log", NULL, strace_format, CONFIG_SRINGBUF_SIZE, NULL);
+#endif
 }
 
 void strace_close() {
@@ -25,13 +32,11 @@ void strace_close() {
 }
 
 void strace_write(word_t pc, word_t code) {
-    char msg[MSG_LEN];
-    snprintf(msg, MSG_LEN, "[Strace]: System call 0x%08x @PC 0x%08x", code, pc);
+    trace_rec rec = {.pc = pc, .data = code, .cycle = sim_cycle()};
+    ringbuf_write(rb, &rec);
 #ifdef CONFIG_STRACE_WRITE_LOG
-    fprintf(strace_fp, "%s\n", msg);
-    fflush(strace_fp);
+    tsink_write(sink, &rec);
 #endif
-    ringbuf_write(rb, msg);
 }
 
 void strace_print() {
@@ -39,6 +44,4 @@ void strace_print() {
     ringbuf_print(rb);
 }
 
-#undef MSG_LEN
-
 #endif
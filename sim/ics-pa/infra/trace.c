@@ -21,9 +21,15 @@ void init_trace(const char *elf) {
 #ifdef CONFIG_STRACE
     strace_init(elf);
 #endif
+#ifdef CONFIG_TRACE_SINK
+    tsink_start();
+#endif
 }
 
 void close_trace() {
+#ifdef CONFIG_TRACE_SINK
+    tsink_stop();
+#endif
 #ifdef CONFIG_ITRACE
     itrace_close();
 #endif
@@ -0,0 +1,250 @@
+// ------------------------------------------------------------------------------------------------
+// Copyright (c) 2023. Heqing Huang (feipenghhq@gmail.com)
+//
+// Project: NRC
+// Author: Heqing Huang
+// Date Created: 10/18/2026
+//
+// ------------------------------------------------------------------------------------------------
+// Trace sink: write the trace log from a background thread
+// ------------------------------------------------------------------------------------------------
+// Each tracer owns a sink. The simulation thread only puts the raw record into the sink's ring
+// buffer. A writer thread drains all the sinks, encodes the records into a large buffer,
+// optionally compresses it with zstd and writes it to the log file in big blocks.
+// The log file is rotated when it reaches CONFIG_TRACE_SINK_ROTATE_SIZE MB:
+// name -> name.1 -> name.2 ... and only CONFIG_TRACE_SINK_ROTATE_KEEP old files are kept.
+// ------------------------------------------------------------------------------------------------
+
+#include <pthread.h>
+#include <time.h>
+#include <string.h>
+#include "tsink.h"
+
+#ifdef CONFIG_TRACE_SINK
+
+#ifdef CONFIG_TRACE_SINK_ZSTD
+#include <zstd.h>
+#define TSINK_EXT ".zst"
+#else
+#define TSINK_EXT ""
+#endif
+
+#define TSINK_MAX       8
+#define TSINK_NAME_LEN  256
+#define TSINK_BUF_SIZE  (1 << 20)
+#define TSINK_IDLE_NS   100000
+#define TSINK_ROTATE    ((uint64_t) CONFIG_TRACE_SINK_ROTATE_SIZE << 20)
+
+struct tsink {
+    ringbuf *rb;            // records from the simulation thread
+    tsink_enc enc;          // NULL: format the record with the ring buffer format function
+    char name[TSINK_NAME_LEN];
+    const char *header;     // written to the beginning of each log file
+    FILE *fp;
+    uint64_t fsize;         // bytes written to the current log file
+    char *buf;              // encoded records not written yet
+    int len;
+#ifdef CONFIG_TRACE_SINK_ZSTD
+    ZSTD_CCtx *cctx;
+    char *zbuf;
+    size_t zsize;
+#endif
+};
+
+static tsink *sinks[TSINK_MAX];
+static int nr_sink = 0;
+static pthread_t writer;
+static bool running = false;
+static int stop = 0;
+
+// ----------------------------------------------
+// Log file
+// ----------------------------------------------
+
+static void tsink_put(tsink *s, const char *data, int len);
+
+static void tsink_fopen(tsink *s) {
+    char path[TSINK_NAME_LEN + 8];
+    snprintf(path, sizeof(path), "%s%s", s->name, TSINK_EXT);
+    s->fp = fopen(path, "wb");
+    Check(s->fp, "Failed to open %s", path);
+    s->fsize = 0;
+    if (s->header) tsink_put(s, s->header, strlen(s->header));
+}
+
+static void tsink_fwrite(tsink *s, const void *data, size_t len) {
+    size_t rc = fwrite(data, 1, len, s->fp);
+    Check(rc == len, "Failed to write trace log %s", s->name);
+    s->fsize += len;
+}
+
+#ifdef CONFIG_TRACE_SINK_ZSTD
+static void tsink_compress(tsink *s, const char *data, size_t len, ZSTD_EndDirective mode) {
+    ZSTD_inBuffer in = {data, len, 0};
+    bool done = false;
+    while (!done) {
+        ZSTD_outBuffer out = {s->zbuf, s->zsize, 0};
+        size_t rem = ZSTD_compressStream2(s->cctx, &out, &in, mode);
+        Check(!ZSTD_isError(rem), "zstd: %s", ZSTD_getErrorName(rem));
+        tsink_fwrite(s, s->zbuf, out.pos);
+        done = (mode == ZSTD_e_end) ? (rem == 0) : (in.pos == in.size);
+    }
+}
+#endif
+
+static void tsink_flush(tsink *s) {
+    if (s->len == 0) return;
+#ifdef CONFIG_TRACE_SINK_ZSTD
+    tsink_compress(s, s->buf, s->len, ZSTD_e_continue);
+#else
+    tsink_fwrite(s, s->buf, s->len);
+#endif
+    s->len = 0;
+}
+
+static void tsink_fclose(tsink *s) {
+    tsink_flush(s);
+#ifdef CONFIG_TRACE_SINK_ZSTD
+    tsink_compress(s, NULL, 0, ZSTD_e_end);
+#endif
+    fclose(s->fp);
+    s->fp = NULL;
+}
+
+static void tsink_rotate(tsink *s) {
+    char from[TSINK_NAME_LEN + 16], to[TSINK_NAME_LEN + 16];
+    tsink_fclose(s);
+    for (int i = CONFIG_TRACE_SINK_ROTATE_KEEP; i > 0; i--) {
+        if (i > 1) snprintf(from, sizeof(from), "%s%s.%d", s->name, TSINK_EXT, i - 1);
+        else snprintf(from, sizeof(from), "%s%s", s->name, TSINK_EXT);
+        snprintf(to, sizeof(to), "%s%s.%d", s->name, TSINK_EXT, i);
+        rename(from, to);
+    }
+    tsink_fopen(s);
+}
+
+static void tsink_put(tsink *s, const char *data, int len) {
+    if (s->len + len > TSINK_BUF_SIZE) tsink_flush(s);
+    memcpy(s->buf + s->len, data, len);
+    s->len += len;
+}
+
+// ----------------------------------------------
+// Writer thread
+// ----------------------------------------------
+
+static int tsink_text(tsink *s, const trace_rec *rec, char *buf) {
+    s->rb->fmt(rec, buf, s->rb->size);
+    int len = strlen(buf);
+    buf[len++] = '\n';
+    return len;
+}
+
+/**
+ * Move the records from the ring buffer to the log. Return number of records
+ */
+static uint64_t tsink_drain(tsink *s) {
+    char msg[s->rb->size + 1];
+    trace_rec rec;
+    uint64_t n = 0;
+    while (ringbuf_read(s->rb, &rec)) {
+        int len = s->enc ? s->enc(&rec, msg, s->rb->size) : tsink_text(s, &rec, msg);
+        tsink_put(s, msg, len);
+        n++;
+    }
+    if (CONFIG_TRACE_SINK_ROTATE_SIZE && s->fsize >= TSINK_ROTATE) tsink_rotate(s);
+    return n;
+}
+
+static void *tsink_writer(void *arg) {
+    struct timespec idle = {0, TSINK_IDLE_NS};
+    while (!__atomic_load_n(&stop, __ATOMIC_ACQUIRE)) {
+        uint64_t n = 0;
+        for (int i = 0; i < nr_sink; i++) n += tsink_drain(sinks[i]);
+        if (n == 0) {
+            // nothing to do, write out what we have and wait for more records
+            for (int i = 0; i < nr_sink; i++) tsink_flush(sinks[i]);
+            nanosleep(&idle, NULL);
+        }
+    }
+    return NULL;
+}
+
+// ----------------------------------------------
+// API
+// ----------------------------------------------
+
+/**
+ * Create a trace sink writing to log file <name>
+ * header: string written to the beginning of each log file. Can be NULL
+ * fmt:    format the record into text with at most size bytes
+ * enc:    encode the record. Use the text from fmt if it is NULL
+ */
+tsink *tsink_open(const char *name, const char *header, ringbuf_fmt fmt, int size, tsink_enc enc) {
+    Check(nr_sink < TSINK_MAX, "Too many trace sinks");
+    Check(!running, "Trace sink %s is opened after the writer is started", name);
+    tsink *s = (tsink *) malloc(sizeof(tsink));
+    CheckMalloc(s);
+    memset(s, 0, sizeof(tsink));
+    s->rb = ringbuf_create(CONFIG_TRACE_SINK_ENTRY, size, fmt);
+    s->enc = enc;
+    s->header = header;
+    snprintf(s->name, TSINK_NAME_LEN, "%s", name);
+    s->buf = (char *) malloc(TSINK_BUF_SIZE);
+    CheckMalloc(s->buf);
+#ifdef CONFIG_TRACE_SINK_ZSTD
+    s->cctx = ZSTD_createCCtx();
+    CheckMalloc(s->cctx);
+    s->zsize = ZSTD_CStreamOutSize();
+    s->zbuf = (char *) malloc(s->zsize);
+    CheckMalloc(s->zbuf);
+#endif
+    tsink_fopen(s);
+    sinks[nr_sink++] = s;
+    return s;
+}
+
+ringbuf *tsink_ringbuf(tsink *sink) {
+    return sink->rb;
+}
+
+void tsink_start() {
+    if (nr_sink == 0) return;
+    int rc = pthread_create(&writer, NULL, tsink_writer, NULL);
+    Check(rc == 0, "Failed to create the trace writer thread");
+    running = true;
+}
+
+/**
+ * Stop the writer thread and write all the remaining records
+ */
+void tsink_stop() {
+    if (running) {
+        __atomic_store_n(&stop, 1, __ATOMIC_RELEASE);
+        pthread_join(writer, NULL);
+        running = false;
+    }
+    for (int i = 0; i < nr_sink; i++) {
+        tsink *s = sinks[i];
+        tsink_drain(s);
+        tsink_fclose(s);
+        if (s->rb->lost) log_warn("%lu records are dropped from trace log %s", s->rb->lost, s->name);
+    #ifdef CONFIG_TRACE_SINK_ZSTD
+        ZSTD_freeCCtx(s->cctx);
+        free(s->zbuf);
+    #endif
+        ringbuf_delete(s->rb);
+        free(s->buf);
+        free(s);
+    }
+    nr_sink = 0;
+}
+
+#undef TSINK_EXT
+#undef TSINK_MAX
+#undef TSINK_NAME_LEN
+#undef TSINK_BUF_SIZE
+#undef TSINK_IDLE_NS
+#undef TSINK_ROTATE
+
+#endif
@@ -0,0 +1,159 @@
+/* ------------------------------------------------------------------------------------------------
+ * Copyright (c) 2023. Heqing Huang (feipenghhq@gmail.com)
+ *
+ * Project: NRC
+ * Author: Heqing Huang
+ * Date Created: 10/18/2026
+ *
+ * ------------------------------------------------------------------------------------------------
+ * loader: ELF loader
+ * ------------------------------------------------------------------------------------------------
+ * The ELF file is mapped into host memory once and shared by the loader and the tracers.
+ * Each PT_LOAD segment is placed in the guest memory at its physical address:
+ * - With CONFIG_MEM_MMAP_IMAGE, the pages fully covered by the file data are mapped copy-on-write
+ *   from the file when the file offset and the guest address are page congruent. Other parts are
+ *   copied. Without it, the file data is copied.
+ * - The .bss part is not read from the file. The guest memory is an anonymous mapping so it is
+ *   already zero. Only the partial page after the file data is cleared.
+ * ------------------------------------------------------------------------------------------------
+ */
+
+#include <elf.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "config.h"
+#include "paddr.h"
+#include "loader.h"
+
+//----------------------------------------------
+// Function prototype, global variable
+//-----------------------------------------------
+
+#define ELF_CACHE_SIZE 8
+
+typedef struct elf_file {
+    char *name;
+    int fd;
+    const byte_t *addr;
+    size_t size;
+} elf_file;
+
+static elf_file elf_cache[ELF_CACHE_SIZE];
+static int nr_elf = 0;
+
+byte_t *mem_ptr();
+
+//----------------------------------------------
+// Functions
+//-----------------------------------------------
+
+static elf_file *elf_lookup(const char *name) {
+    for (int i = 0; i < nr_elf; i++) {
+        if (strcmp(elf_cache[i].name, name) == 0) return &elf_cache[i];
+    }
+    Check(nr_elf < ELF_CACHE_SIZE, "Too many ELF files");
+    elf_file *f = &elf_cache[nr_elf];
+    f->fd = open(name, O_RDONLY);
+    Check(f->fd >= 0, "Can't open file %s", name);
+    struct stat statbuf;
+    int rc = fstat(f->fd, &statbuf);
+    Check(rc == 0, "Failed to stat file %s", name);
+    f->size = statbuf.st_size;
+    f->addr = (const byte_t *) mmap(NULL, f->size, PROT_READ, MAP_PRIVATE, f->fd, 0);
+    Check(f->addr != MAP_FAILED, "mmap failed to map elf file %s into memory", name);
+    f->name = strdup(name);
+    CheckMalloc(f->name);
+    const Elf32_Ehdr *ehdr = (const Elf32_Ehdr *) f->addr;
+    Check(f->size >= sizeof(Elf32_Ehdr) && memcmp(ehdr->e_ident, ELFMAG, SELFMAG) == 0,
+          "%s is not an ELF file", name);
+    Check(ehdr->e_ident[EI_CLASS] == ELFCLASS32, "%s is not a 32 bit ELF file", name);
+    nr_elf++;
+    return f;
+}
+
+/**
+ * Open the ELF file and return the ELF header
+ * The file is only mapped once and stays mapped till the end of the simulation
+ */
+const void *elf_open(const char *name) {
+    return elf_lookup(name)->addr;
+}
+
+/**
+ * Check if the file is an ELF file
+ */
+bool is_elf(const char *name) {
+    char magic[SELFMAG];
+    FILE *fp = fopen(name, "rb");
+    Check(fp, "Can't open file %s", name);
+    size_t rc = fread(magic, 1, SELFMAG, fp);
+    fclose(fp);
+    return rc == SELFMAG && memcmp(magic, ELFMAG, SELFMAG) == 0;
+}
+
+/**
+ * Place one PT_LOAD segment in the guest memory
+ */
+static void load_segment(elf_file *f, const Elf32_Phdr *ph) {
+    uintptr_t page = sysconf(_SC_PAGESIZE);
+    word_t addr = ph->p_paddr;
+    Check(ph->p_filesz <= ph->p_memsz && ph->p_offset + ph->p_filesz <= f->size,
+          "Invalid segment at 0x%08x in %s", addr, f->name);
+    Check(in_pmem(addr) && (ph->p_memsz == 0 || in_pmem(addr + ph->p_memsz - 1)),
+          "Segment [0x%08x, 0x%08x) is out of the memory", addr, addr + ph->p_memsz);
+
+    uintptr_t dst = (uintptr_t) mem_ptr() + (addr - MEM_BASE);
+    uintptr_t src = ph->p_offset;
+    uintptr_t end = dst + ph->p_filesz;
+#ifdef CONFIG_MEM_MMAP_IMAGE
+    // the whole pages covered by the file data can be mapped directly from the file
+    uintptr_t map_start = (dst + page - 1) & ~(page - 1);
+    uintptr_t map_end = end & ~(page - 1);
+    bool mappable = ((dst - src) & (page - 1)) == 0 && map_start < map_end;
+#else
+    uintptr_t map_start = 0, map_end = 0;
+    bool mappable = false;
+#endif
+    if (mappable) {
+        void *p = mmap((void *) map_start, map_end - map_start, PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_FIXED, f->fd, src + (map_start - dst));
+        Check(p != MAP_FAILED, "Failed to map segment at 0x%08x from %s", addr, f->name);
+        memcpy((void *) dst, f->addr + src, map_start - dst);
+        memcpy((void *) map_end, f->addr + src + (map_end - dst), end - map_end);
+    }
+    else {
+        memcpy((void *) dst, f->addr + src, ph->p_filesz);
+    }
+    // .bss: clear the rest of the page after the file data. The following pages are still zero
+    uintptr_t bss_end = dst + ph->p_memsz;
+    uintptr_t page_end = (end + page - 1) & ~(page - 1);
+    memset((void *) end, 0, (bss_end < page_end ? bss_end : page_end) - end);
+}
+
+/**
+ * Load the ELF file to memory
+ * Return the size of the loaded memory from MEM_BASE and set the entry point
+ */
+size_t load_elf(const char *name, word_t *entry) {
+    elf_file *f = elf_lookup(name);
+    const Elf32_Ehdr *ehdr = (const Elf32_Ehdr *) f->addr;
+    Check(ehdr->e_machine == EM_RISCV, "%s is not a RISC-V ELF file", name);
+    Check(ehdr->e_type == ET_EXEC, "%s is not an executable ELF file", name);
+    size_t size = 0;
+    for (int i = 0; i < ehdr->e_phnum; i++) {
+        const Elf32_Phdr *ph = (const Elf32_Phdr *) (f->addr + ehdr->e_phoff + i * ehdr->e_phentsize);
+        if (ph->p_type != PT_LOAD || ph->p_memsz == 0) continue;
+        load_segment(f, ph);
+        size_t top = ph->p_paddr - MEM_BASE + ph->p_memsz;
+        if (top > size) size = top;
+        log_info("Load segment [0x%08x, 0x%08x) file size 0x%x",
+                 ph->p_paddr, ph->p_paddr + ph->p_memsz, ph->p_filesz);
+    }
+    *entry = ehdr->e_entry;
+    log_info("ELF entry point: 0x%08x", *entry);
+    return size;
+}
+
+#undef ELF_CACHE_SIZE
@@ -11,6 +11,7 @@
 #include "common.h"
 #include "device.h"
 #include "config.h"
+#include "checkpoint.h"
 
 //----------------------------------------------
 // Function prototype, global variable
@@ -21,6 +22,15 @@ void difftest_skip_ref();
 // assign the mmio space into stack
 static byte_t mmio[MMIO_SIZE];
 
+#ifdef CONFIG_WAVE
+// MMIO address that triggers the waveform dump. 0 never matches
+word_t wave_mmio_addr = 0;
+void wave_mmio_hit();
+#define WAVE_MMIO_CHECK(addr) do {if (unlikely(((addr) & ~0x3) == wave_mmio_addr)) wave_mmio_hit();} while (0)
+#else
+#define WAVE_MMIO_CHECK(addr)
+#endif
+
 //----------------------------------------------
 // Functions
 //-----------------------------------------------
@@ -34,6 +44,7 @@ word_t mmio_read(word_t addr) {
 #ifdef CONFIG_DIFFTEST
     difftest_skip_ref();
 #endif
+    WAVE_MMIO_CHECK(addr);
     uintptr_t offset = addr - MMIO_BASE;
     uintptr_t paddr = (uintptr_t) mmio + offset;
     paddr = paddr & ADDR_MASK; // make addr align to word boundary
@@ -49,6 +60,7 @@ void mmio_write(word_t addr, word_t data) {
 #ifdef CONFIG_DIFFTEST
     difftest_skip_ref();
 #endif
+    WAVE_MMIO_CHECK(addr);
     uintptr_t offset = addr - MMIO_BASE;
     uintptr_t paddr = (uintptr_t) mmio + offset;
     paddr = paddr & ADDR_MASK; // make addr align to word boundary
@@ -63,3 +75,16 @@ void mmio_write(word_t addr, word_t data) {
 byte_t *mmio_ptr() {
     return mmio;
 }
+
+#ifdef CONFIG_CHECKPOINT
+
+void mmio_save(ckpt_t *c) {
+    ckpt_write_pages(c, mmio, MMIO_SIZE);
+}
+
+void mmio_restore(ckpt_t *c) {
+    memset(mmio, 0, MMIO_SIZE);
+    ckpt_read_pages(c, mmio, MMIO_SIZE);
+}
+
+#endif
@@ -10,18 +10,39 @@
 
 #include <stdio.h>
 #include <stdint.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include "config.h"
 #include "paddr.h"
 #include "mmio.h"
+#include "loader.h"
+#include "checkpoint.h"
 
 //----------------------------------------------
 // Function prototype, global variable
 //-----------------------------------------------
 
-#define ADDR_MASK (UINTPTR_MAX-0x3)
+#define ADDR_MASK (~(word_t) 0x3)
 
-extern FILE *mtrace_fp;
-static byte_t mem[MSIZE]; // assign the memory into stack
+// trace hook. Compiled out when the trace is disabled
+#ifdef CONFIG_MTRACE
+#define MTRACE_HOOK(...) mtrace_write(__VA_ARGS__)
+#else
+#define MTRACE_HOOK(...)
+#endif
+
+// byte mask for each strobe value
+static const word_t strb_mask[16] = {
+    0x00000000, 0x000000ff, 0x0000ff00, 0x0000ffff,
+    0x00ff0000, 0x00ff00ff, 0x00ffff00, 0x00ffffff,
+    0xff000000, 0xff0000ff, 0xff00ff00, 0xff00ffff,
+    0xffff0000, 0xffff00ff, 0xffffff00, 0xffffffff,
+};
+
+static byte_t *mem = NULL;  // guest memory. Pages are allocated by the OS on first access
+size_t pmem_size = 0;
 
 void mtrace_write(word_t addr, word_t data, word_t strb, bool is_write, bool ifetch);
 
@@ -29,59 +50,86 @@ void mtrace_write(word_t addr, word_t data, word_t strb, bool is_write, bool ife
 // Functions
 //-----------------------------------------------
 
+/**
+ * Create the guest memory
+ * The memory is an anonymous mapping without swap reservation so only the pages
+ * touched by the program take host memory.
+ */
+void init_mem(size_t size) {
+    size_t page = sysconf(_SC_PAGESIZE);
+    size = (size + page - 1) & ~(page - 1);
+    // the memory must not overlap the MMIO region
+    Check(size && size <= (size_t) (MMIO_BASE - MEM_BASE), "Invalid memory size: 0x%lx", size);
+    mem = (byte_t *) mmap(NULL, size, PROT_READ | PROT_WRITE,
+                          MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    Check(mem != MAP_FAILED, "Failed to allocate %ld MB guest memory", size >> 20);
+    pmem_size = size;
+    log_info("Guest memory: [0x%08x, 0x%08lx)", MEM_BASE, MEM_BASE + size);
+}
+
 /**
  * Load the image to memory
- * The image file should be a binary file
+ * The image file can be an ELF file or a binary file. Binary file is loaded at MEM_BASE
+ * and starts from the reset PC. Return the size of the loaded memory and set the entry point
  */
-size_t load_image(const char *img) {
+size_t load_image(const char *img, word_t *entry) {
     Check(img, "Please specify the image file");
     log_info("Loading image file: %s", img);
-    FILE *fp = fopen(img, "rb");
-    Check(fp, "Can't open file %s", img);
-
-    fseek(fp, 0, SEEK_END);
-    size_t size = ftell(fp);
-    rewind(fp);
-
-    size_t rc = fread((void *) mem, size, 1, fp);
-    Check(rc, "Failed to read the image file: %s", img);
+    if (is_elf(img)) return load_elf(img, entry);
+    *entry = PC_RESET_OFFSET;
+    int fd = open(img, O_RDONLY);
+    Check(fd >= 0, "Can't open file %s", img);
+    struct stat statbuf;
+    int rc = fstat(fd, &statbuf);
+    Check(rc == 0, "Failed to stat the image file: %s", img);
+    size_t size = statbuf.st_size;
+    Check(size <= pmem_size, "Image file %s is larger than the memory", img);
+
+#ifdef CONFIG_MEM_MMAP_IMAGE
+    // map the image copy-on-write on top of the guest memory. The pages are read from
+    // the file on first access and only copied when the program writes to them.
+    void *addr = mmap(mem, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_FIXED, fd, 0);
+    Check(addr != MAP_FAILED, "Failed to map the image file: %s", img);
+#else
+    ssize_t len = read(fd, mem, size);
+    Check(len == size, "Failed to read the image file: %s", img);
+#endif
+    close(fd);
 
     return size;
 }
 
+/**
+ * Host address of the word containing addr
+ */
+static inline word_t *pmem_word(word_t addr) {
+    return (word_t *) (mem + ((addr - MEM_BASE) & ADDR_MASK));
+}
+
 /**
  * read memory. always read word_t size
+ * The addr is aligned to word boundary because the hardware always read a word each time
  */
 word_t pmem_read(word_t addr, bool ifetch) {
-    uintptr_t offset = addr - MEM_BASE;
-    uintptr_t paddr = (uintptr_t) mem + offset;
-#ifdef CONFIG_MTRACE
-    word_t data = *((word_t *) paddr); // this is byte aligned not word aligned
-    mtrace_write(addr, data, 0, false, ifetch);
-#endif
-    // make the addr word boundary aligned because the hardware always read
-    // a word each time
-    paddr = paddr & ADDR_MASK;
-    return *((word_t *) paddr);
+    word_t data = *pmem_word(addr);
+    MTRACE_HOOK(addr, data, 0, false, ifetch);
+    return data;
 }
 
 /**
  * write memory. always write word_t size
+ * Full word write is a single store. Partial write merges the strobed bytes with the mask.
  */
 void pmem_write(word_t addr, word_t data, char strb) {
-    uintptr_t offset = addr - MEM_BASE;
-    uintptr_t paddr = (uintptr_t) mem + offset;
-    // make the addr word boundary aligned
-    paddr = paddr & ADDR_MASK;
-    // only support for 32b data
-    for (int i = 0; i < NUM_BYTE; i++) {
-        if ((strb & (0x1 << i)) != 0) {
-            *((byte_t *) (paddr + i)) = (byte_t) (data >> (8*i));
-        }
+    word_t *ptr = pmem_word(addr);
+    word_t mask = strb_mask[strb & 0xf];
+    if (likely(mask == 0xffffffff)) {
+        *ptr = data;
     }
-#ifdef CONFIG_MTRACE
-    mtrace_write(addr, data, strb, true, false);
-#endif
+    else {
+        *ptr = (*ptr & ~mask) | (data & mask);
+    }
+    MTRACE_HOOK(addr, data, strb, true, false);
 }
 
 byte_t *mem_ptr() {
@@ -118,3 +166,22 @@ word_t paddr_read(word_t addr, bool ifetch) {
     return 0;
 }
 
+#ifdef CONFIG_CHECKPOINT
+
+void pmem_save(ckpt_t *c) {
+    ckpt_write_var(c, pmem_size);
+    ckpt_write_pages(c, mem, pmem_size);
+}
+
+void pmem_restore(ckpt_t *c) {
+    size_t size;
+    ckpt_read_var(c, size);
+    Check(size == pmem_size, "Memory size in checkpoint 0x%lx does not match 0x%lx", size, pmem_size);
+    // drop the current content with a fresh anonymous mapping before reading the pages
+    void *addr = mmap(mem, pmem_size, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE | MAP_FIXED, -1, 0);
+    Check(addr != MAP_FAILED, "Failed to clear guest memory");
+    ckpt_read_pages(c, mem, pmem_size);
+}
+
+#endif
@@ -0,0 +1,229 @@
+#!/usr/bin/env python3
+# ------------------------------------------------------------------------------------------------
+# Copyright (c) 2023. Heqing Huang (feipenghhq@gmail.com)
+#
+# Project: NRC
+# Author: Heqing Huang
+# Date Created: 10/18/2026
+# ------------------------------------------------------------------------------------------------
+# Regression driver for the ICS PA tests
+#
+# Runs the tests of the selected groups in parallel. Each test runs in its own working directory
+# <output>/<group>/<test> with a wall time limit and a cycle budget. The results are printed and
+# written to <output>/result.json and <output>/result.xml (JUnit).
+# ------------------------------------------------------------------------------------------------
+
+import argparse
+import json
+import os
+import re
+import signal
+import subprocess
+import sys
+import time
+import xml.etree.ElementTree as ET
+from concurrent.futures import ThreadPoolExecutor, as_completed
+
+COLOR_RED   = '\033[1;31m'
+COLOR_GREEN = '\033[1;32m'
+COLOR_NONE  = '\033[0m'
+
+SIM_ICS_PA_DIR = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+
+# Test groups of the ics2023 suite: group -> (home environment variable, path, interactive)
+# Interactive groups wait for the user to quit so they have no timeout by default.
+# The group without home environment variable is in this repository (relative to sim/ics-pa).
+ICS2023_GROUPS = {
+    'directed':     (None,              'tests/directed',           False),
+    'cpu-test':     ('AM_KERNELS_HOME', 'tests/cpu-tests',          False),
+    'am-test':      ('AM_KERNELS_HOME', 'tests/am-tests',           False),
+    'alu-test':     ('AM_KERNELS_HOME', 'tests/alu-tests',          False),
+    'coremark':     ('AM_KERNELS_HOME', 'benchmarks/coremark',      False),
+    'dhrystone':    ('AM_KERNELS_HOME', 'benchmarks/dhrystone',     False),
+    'microbench':   ('AM_KERNELS_HOME', 'benchmarks/microbench',    False),
+    'demo':         ('AM_KERNELS_HOME', 'kernels/demo',             True),
+    'typing-game':  ('AM_KERNELS_HOME', 'kernels/typing-game',      True),
+    'bad-apple':    ('AM_KERNELS_HOME', 'kernels/bad-apple',        True),
+    'fceux':        ('FCEUX_AM_HOME',   '',                         True),
+    'nanos-lite':   ('NANOS_HOME',      '',                         True),
+}
+
+SUITES = {
+    'ics2023': ICS2023_GROUPS,
+}
+
+RE_CYCLE = re.compile(r'Simulation speed: \d+ cycles/s \((\d+) cycles in')
+RE_BUDGET = re.compile(r'Test did not finish in \d+ cycles')
+RE_BRANCH = re.compile(r'Branch prediction accuracy: ([\d.]+)%')
+
+
+def find_tests(groups, group):
+    """ Find the tests of a group: all the *-npc.bin under the group path """
+    env, path, interactive = groups[group]
+    home = os.environ.get(env) if env else SIM_ICS_PA_DIR
+    if not home:
+        sys.exit(f'[ERROR] Please set {env} to run {group}')
+    path = os.path.join(home, path)
+    tests = []
+    for root, _, files in os.walk(path):
+        for f in files:
+            if f.endswith('-npc.bin'):
+                tests.append(f[:-len('.bin')])
+    return [(group, t, os.path.join(path, 'build'), interactive) for t in sorted(set(tests))]
+
+
+def run_test(args, group, test, build, interactive):
+    """ Run a single test in its own working directory """
+    workdir = os.path.join(args.output, group, test)
+    os.makedirs(workdir, exist_ok=True)
+    cmd = [args.sim,
+           '--image', os.path.join(build, test + '.bin'),
+           '--elf', os.path.join(build, test + '.elf'),
+           '--suite', args.suite, '--test', test, '--dut', args.dut]
+    if args.ref:
+        cmd += ['--ref', args.ref]
+    if args.max_cycle:
+        cmd += ['--max-cycle', str(args.max_cycle)]
+    timeout = None if interactive or args.timeout <= 0 else args.timeout
+
+    begin = time.monotonic()
+    with open(os.path.join(workdir, 'sim.log'), 'w') as out:
+        # new session so the whole process group can be killed on timeout
+        proc = subprocess.Popen(cmd, cwd=workdir, stdout=out, stderr=subprocess.STDOUT,
+                                start_new_session=True)
+        try:
+            rc = proc.wait(timeout=timeout)
+            status = 'PASS' if rc == 0 else 'FAIL'
+        except subprocess.TimeoutExpired:
+            os.killpg(proc.pid, signal.SIGKILL)
+            rc = proc.wait()
+            status = 'TIMEOUT'
+    wall = time.monotonic() - begin
+
+    cycles = None
+    branch_accuracy = None
+    log = ''
+    log_name = os.path.join(workdir, 'run.log')
+    if os.path.exists(log_name):
+        with open(log_name, errors='replace') as f:
+            log = f.read()
+        m = RE_CYCLE.search(log)
+        if m:
+            cycles = int(m.group(1))
+        m = RE_BRANCH.search(log)
+        if m:
+            branch_accuracy = float(m.group(1))
+        if status == 'FAIL' and RE_BUDGET.search(log):
+            status = 'CYCLE'
+    return {
+        'group': group,
+        'test': test,
+        'status': status,
+        'returncode': rc,
+        'wall_time': round(wall, 3),
+        'cycles': cycles,
+        'branch_accuracy': branch_accuracy,
+        'workdir': workdir,
+        'log_tail': '\n'.join(log.splitlines()[-args.log_tail:]) if status != 'PASS' else '',
+    }
+
+
+def write_json(name, args, results, wall):
+    with open(name, 'w') as f:
+        json.dump({
+            'suite': args.suite,
+            'dut': args.dut,
+            'jobs': args.jobs,
+            'wall_time': round(wall, 3),
+            'passed': sum(r['status'] == 'PASS' for r in results),
+            'failed': sum(r['status'] != 'PASS' for r in results),
+            'tests': [{k: v for k, v in r.items() if k != 'log_tail'} for r in results],
+        }, f, indent=2)
+
+
+def write_junit(name, args, results, wall):
+    root = ET.Element('testsuites', name=args.suite, tests=str(len(results)), time=f'{wall:.3f}',
+                      failures=str(sum(r['status'] != 'PASS' for r in results)))
+    for group in dict.fromkeys(r['group'] for r in results):
+        rs = [r for r in results if r['group'] == group]
+        suite = ET.SubElement(root, 'testsuite', name=group, tests=str(len(rs)),
+                              failures=str(sum(r['status'] != 'PASS' for r in rs)),
+                              time=f"{sum(r['wall_time'] for r in rs):.3f}")
+        for r in rs:
+            case = ET.SubElement(suite, 'testcase', name=r['test'], classname=f"{args.suite}.{group}",
+                                 time=f"{r['wall_time']:.3f}")
+            if r['cycles'] is not None:
+                props = ET.SubElement(case, 'properties')
+                ET.SubElement(props, 'property', name='cycles', value=str(r['cycles']))
+                if r['branch_accuracy'] is not None:
+                    ET.SubElement(props, 'property', name='branch_accuracy', value=str(r['branch_accuracy']))
+            if r['status'] != 'PASS':
+                fail = ET.SubElement(case, 'failure', message=r['status'], type=r['status'])
+                fail.text = r['log_tail']
+    ET.indent(root)
+    ET.ElementTree(root).write(name, encoding='utf-8', xml_declaration=True)
+
+
+def print_result(r, width):
+    color = COLOR_GREEN if r['status'] == 'PASS' else COLOR_RED
+    cycles = r['cycles'] if r['cycles'] is not None else '-'
+    # only the DUT with a branch predictor reports the accuracy
+    branch = f" {r['branch_accuracy']:6.2f}% branch prediction" if r['branch_accuracy'] is not None else ''
+    print(f"[{r['test']:>{width}}] {color}{r['status']}!{COLOR_NONE} "
+          f"{r['wall_time']:8.2f}s {cycles:>12} cycles{branch}", flush=True)
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Run the ICS PA tests in parallel')
+    parser.add_argument('groups', nargs='+', help='test groups to run')
+    parser.add_argument('--sim', required=True, help='verilator executable')
+    parser.add_argument('--suite', default='ics2023', choices=SUITES.keys(), help='test suite')
+    parser.add_argument('--dut', required=True, help='DUT top module name')
+    parser.add_argument('--ref', help='reference for difftest')
+    parser.add_argument('--output', required=True, help='output directory')
+    parser.add_argument('-j', '--jobs', type=int, default=os.cpu_count(), help='number of parallel tests')
+    parser.add_argument('--timeout', type=float, default=600,
+                        help='wall time limit of a test in seconds. 0 for no limit')
+    parser.add_argument('--max-cycle', type=int, default=0, help='cycle budget of a test. 0 for no limit')
+    parser.add_argument('--log-tail', type=int, default=50, help='run.log lines kept in the report on failure')
+    args = parser.parse_args()
+
+    groups = SUITES[args.suite]
+    for g in args.groups:
+        if g not in groups:
+            sys.exit(f'[ERROR] Unknown test group: {g}')
+    args.sim = os.path.abspath(args.sim)
+    args.output = os.path.abspath(args.output)
+    os.makedirs(args.output, exist_ok=True)
+
+    tests = [t for g in dict.fromkeys(args.groups) for t in find_tests(groups, g)]
+    if not tests:
+        sys.exit('[ERROR] No test found')
+    width = max(26, max(len(t[1]) for t in tests))
+
+    begin = time.monotonic()
+    results = []
+    with ThreadPoolExecutor(max_workers=max(1, args.jobs)) as pool:
+        futures = [pool.submit(run_test, args, *t) for t in tests]
+        for fut in as_completed(futures):
+            r = fut.result()
+            results.append(r)
+            print_result(r, width)
+    wall = time.monotonic() - begin
+
+    # report in the test order
+    order = {(t[0], t[1]): i for i, t in enumerate(tests)}
+    results.sort(key=lambda r: order[(r['group'], r['test'])])
+    write_json(os.path.join(args.output, 'result.json'), args, results, wall)
+    write_junit(os.path.join(args.output, 'result.xml'), args, results, wall)
+
+    failed = [r for r in results if r['status'] != 'PASS']
+    print(f'\n{len(results) - len(failed)}/{len(results)} passed in {wall:.2f}s '
+          f"(test time {sum(r['wall_time'] for r in results):.2f}s, {args.jobs} jobs)")
+    for r in failed:
+        print(f"{COLOR_RED}{r['status']}{COLOR_NONE} {r['group']}/{r['test']}: {r['workdir']}")
+    return 1 if failed else 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
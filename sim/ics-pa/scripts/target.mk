@@ -5,12 +5,36 @@
 # Author: Heqing Huang
 # ------------------------------------------------------------------------------------------------
 
-# Target for different test suites
+# Target for different test suites. The tests are run in parallel by the regression driver regress.py
 
 ifeq ($(TEST_SUITES), ics2023)
-	target := cpu-test am-test alu-test coremark dhrystone microbench demo typing-game bad-apple fceux nanos-lite
+	target := directed cpu-test am-test alu-test coremark dhrystone microbench demo typing-game bad-apple fceux nanos-lite
 endif
 
+# test groups run by the regress target
+REGRESS_GROUPS    ?= directed cpu-test am-test alu-test coremark dhrystone microbench
+# number of parallel tests
+REGRESS_JOBS      ?= $(shell nproc)
+# wall time limit of a test in seconds. 0 for no limit
+REGRESS_TIMEOUT   ?= 600
+# cycle budget of a test. 0 for no limit
+REGRESS_MAX_CYCLE ?= 0
+
+# Each test runs in $(OUTPUT_DIR)/test/<group>/<test>. The result is in $(OUTPUT_DIR)/test/result.{json,xml}
+REGRESS = python3 $(SIM_ICS_PA_DIR)/scripts/regress.py --sim $(BUILD_DIR)/$(OBJECT) --suite $(TEST_SUITES) \
+	--dut $(TOP) --ref $(REF_SO) --output $(OUTPUT_DIR)/test -j $(REGRESS_JOBS) \
+	--timeout $(REGRESS_TIMEOUT) --max-cycle $(REGRESS_MAX_CYCLE)
+
 $(target): $(OBJECT)
-	@make -f $(SIM_ICS_PA_DIR)/scripts/ics2023.mk $@ TOP=$(TOP) TEST_SUITES=$(TEST_SUITES) OUTPUT_DIR=$(OUTPUT_DIR) \
-		BUILD_DIR=$(BUILD_DIR) OBJECT=$(OBJECT) RESULT=$(RESULT)
+	@$(REGRESS) $@
+
+regress: $(OBJECT) $(if $(filter directed, $(REGRESS_GROUPS)), directed-build)
+	@$(REGRESS) $(REGRESS_GROUPS)
+
+# The directed tests are built from the source in this repository
+directed: directed-build
+
+directed-build:
+	@$(MAKE) -C $(SIM_ICS_PA_DIR)/tests/directed -s
+
+.PHONY: $(target) regress directed-build
@@ -6,13 +6,14 @@
  * Date Created: 12/19/2023
  *
  * ------------------------------------------------------------------------------------------------
- *  CoreN class: Provide environment for CPU design
+ *  Core class: Provide environment for CPU design
  * ------------------------------------------------------------------------------------------------
  */
 
 #include "Core.h"
 
-#define MAXNIM_TIME 10000
+// number of clock tick (half cycle) between two device updates
+#define DEVICE_UPDATE_TICK (CONFIG_DEVICE_UPDATE_CYCLE * 2)
 
 // ---------------------------------------------
 // C Function prototype
@@ -25,8 +26,6 @@ extern "C" {
     void update_device();
 }
 
-extern FILE *strace_fp;
-
 // ---------------------------------------------
 // Function prototype and global variable
 // ---------------------------------------------
@@ -49,9 +48,9 @@ TOP::~TOP() {
 void TOP::init_trace(const char *name, int level) {
 #ifdef CONFIG_WAVE
     Verilated::traceEverOn(true);
-    m_trace = new VerilatedVcdC;
+    m_trace = new VerilatedFstC;
     top->trace(m_trace, level);
-    m_trace->open(name);
+    wave_init(name);
 #endif
 }
 
@@ -76,38 +75,116 @@ void TOP::reset() {
 }
 
 bool TOP::run(uint64_t step) {
-    int cnt = 0;
-    int done = 0;
-    while(!finished && ((step < 0 && sim_time < MAXNIM_TIME)  || cnt < step)) {
+    uint64_t cnt = 0;
+#ifndef CONFIG_FAST_RUN
+    word_t next_pc = 0;
+    word_t inst = 0;
+#endif
+    uint64_t next_update = sim_time + DEVICE_UPDATE_TICK;
+    run_start();
+    while(!finished && cnt < step) {
+    #ifdef CONFIG_FAST_RUN
+        // Fast run: no per-instruction hook is needed so evaluate the model in a tight batch of cycles.
+        // The batch is broken early when ebreak is hit so the test stops at the same cycle as the normal run.
+        uint64_t batch = step - cnt < CONFIG_RUN_BATCH_CYCLE ? step - cnt : CONFIG_RUN_BATCH_CYCLE;
+        uint64_t i;
+        for (i = 0; i < batch && !dpi_ebreak; i++) {
+            clk_tick();
+            clk_tick();
+        }
+        cnt += i;
+    #else
         clk_tick();
-        // trace need to be put here because the next_pc is updated at this point
-        // while the change has not been committed yet
+        // The commit interface is sampled after the posedge so done tells that an instruction is committed
+        // at the next posedge. The trace need to be put here because the commit signals are still holding
+        // the instruction being committed.
+        if (done) {
+            next_pc = COMMIT_NEXT_PC;
+            inst = COMMIT_INST;
         #if defined(CONFIG_ITRACE) || defined(CONFIG_FTRACE)
-        if (done) trace(PC, NEXT_PC, INSTRUCTION);
+            trace(COMMIT_PC, next_pc, inst);
         #endif
+        }
         clk_tick();
-        // Due to the cpu being multiple cycle now, we need to have a flag to tell when we can do
-        // difftest. We set the done signal when EX stage is done. It will be set at the beginning
-        // of the clock cycle after verilator evaluate the signal. So we should run difftest on
-        // the beginning of next clock so that all the data has been commited
-        #ifdef CONFIG_DIFFTEST
+        // The instruction has been committed at this posedge so all the data is ready for difftest
         if (done) {
-            difftest(PC);
-            done = 0;
-        }
+        #ifdef CONFIG_WAVE
+            if (unlikely(next_pc == wave_pc)) wave_trigger("PC");
         #endif
-        if (DONE) done = 1;
-        update_device();
-        check();
+        #ifdef CONFIG_DIFFTEST
+            difftest(next_pc, inst);
+        #endif
+        }
+        done = COMMIT_VALID;
         cnt++;
+    #endif
+        // Device update (SDL event and VGA sync) is expensive so it only runs every DEVICE_UPDATE_CYCLE cycles.
+        // The finish check is cheap and runs every iteration so the test stops right at the cycle it finishes.
+        bool update = sim_time >= next_update;
+        if (update) {
+            update_device();
+            next_update = sim_time + DEVICE_UPDATE_TICK;
+        }
+        check();
+    #ifdef CONFIG_CHECKPOINT
+        // the finished test is not saved
+        if (update) auto_checkpoint();
+    #endif
     }
+    run_stop();
     return finished;
 }
 
+#ifdef CONFIG_CHECKPOINT
+
+void TOP::save_model(VerilatedSave &os) {
+    os << *top;
+    os.write(&dpi_ebreak, sizeof(dpi_ebreak));
+    os.write(&dpi_mem_access_pc, sizeof(dpi_mem_access_pc));
+    // the pending commit is traced and checked by difftest after the restore
+    os.write(&done, sizeof(done));
+}
+
+void TOP::restore_model(VerilatedRestore &os) {
+    os >> *top;
+    os.read(&dpi_ebreak, sizeof(dpi_ebreak));
+    os.read(&dpi_mem_access_pc, sizeof(dpi_mem_access_pc));
+    os.read(&done, sizeof(done));
+}
+
+#endif
+
+/**
+ * Set the reset vector (the PC after reset). Should be called before reset
+ */
+void TOP::set_reset_vector(word_t pc) {
+    top->rstVector = pc;
+}
+
 word_t TOP::reg_id2val(int id) {
     return REGS[id];
 }
 
+uint64_t TOP::perf_counter(int id) {
+    switch (id) {
+        case PERF_CYCLE:        return PERF_CSR->mcycleCounter;
+        case PERF_INSTRET:      return PERF_CSR->minstretCounter;
+        case PERF_IFU_WAIT:     return PERF_CSR->mhpmcounter3Counter;
+        case PERF_LOAD_WAIT:    return PERF_CSR->mhpmcounter4Counter;
+        case PERF_STORE_WAIT:   return PERF_CSR->mhpmcounter5Counter;
+        case PERF_MULDIV_BUSY:  return PERF_CSR->mhpmcounter6Counter;
+        case PERF_BUS_STALL:    return PERF_CSR->mhpmcounter7Counter;
+        case PERF_ICACHE_HIT:   return PERF_CSR->mhpmcounter8Counter;
+        case PERF_ICACHE_MISS:  return PERF_CSR->mhpmcounter9Counter;
+        case PERF_DCACHE_HIT:   return PERF_CSR->mhpmcounter10Counter;
+        case PERF_DCACHE_MISS:  return PERF_CSR->mhpmcounter11Counter;
+        case PERF_DCACHE_WB:    return PERF_CSR->mhpmcounter12Counter;
+        case PERF_BRANCH:       return PERF_CSR->mhpmcounter13Counter;
+        case PERF_MISPREDICT:   return PERF_CSR->mhpmcounter14Counter;
+        default:                return 0;
+    }
+}
+
 // ---------------------------------------------
 // DPI function
 // ---------------------------------------------
@@ -119,13 +196,29 @@ extern "C" {
     }
 
     void dpi_pmem_read(int pc, int addr, int *rdata, svBit ifetch) {
-        *rdata = paddr_read(addr, ifetch);
         dpi_mem_access_pc = pc;
+        *rdata = paddr_read(addr, ifetch);
     }
 
     void dpi_pmem_write(int pc, int addr, int data, char strb) {
+        dpi_mem_access_pc = pc;
         paddr_write(addr, data, strb);
+    }
+
+    // read/write a whole burst of nword words with a single DPI call
+    void dpi_pmem_read_burst(int pc, int addr, int nword, svBitVecVal *rdata, svBit ifetch) {
         dpi_mem_access_pc = pc;
+        for (int i = 0; i < nword; i++) {
+            rdata[i] = paddr_read(addr + i * 4, ifetch);
+        }
+    }
+
+    void dpi_pmem_write_burst(int pc, int addr, int nword, const svBitVecVal *wdata, const svBitVecVal *wstrb) {
+        dpi_mem_access_pc = pc;
+        for (int i = 0; i < nword; i++) {
+            char strb = (wstrb[i / 8] >> (i % 8 * 4)) & 0xf;
+            if (strb) paddr_write(addr + i * 4, wdata[i], strb);
+        }
     }
 
     void dpi_strace(int pc, int code) {
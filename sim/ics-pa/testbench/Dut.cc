@@ -24,19 +24,31 @@ extern "C" {
     const char *reg_id2str(int id);
     void ref_exec(uint64_t n, word_t *dut_reg, word_t *dut_pc);
     bool difftest_compare(word_t *dut_reg, word_t dut_pc);
+    bool difftest_step(word_t *dut_reg, word_t dut_pc, word_t inst);
+    bool difftest_flush();
     void init_trace(const char *elf);
     void close_trace();
     void print_trace();
     void itrace_write(word_t pc, word_t inst);
     void ftrace_write(word_t pc, word_t nxtpc, word_t inst);
+    struct ckpt;
+    void ckpt_save_state(struct ckpt *c);
+    void ckpt_restore_state(struct ckpt *c);
 }
 
 // ---------------------------------------------
 // Function prototype and global variable
 // ---------------------------------------------
 
-bool check_finish(Dut *top, const char *suite);
-bool check_pass(Dut *top, const char *suite);
+void init_check(const char *suite);
+bool check_finish(Dut *top);
+bool check_pass(Dut *top);
+
+static Dut *sim_dut = NULL;     // the dut being simulated. Used by the C side to get the cycle
+
+extern "C" uint64_t sim_cycle() {
+    return sim_dut ? sim_dut->sim_time / 2 : 0;
+}
 
 // ---------------------------------------------
 // Class functions
@@ -46,16 +58,29 @@ Dut::Dut(int argc, char *argv[], const test_info *info) {
     Verilated::commandArgs(argc, argv);
     this->info = info;
     sim_time = 0;
+#ifdef CONFIG_WAVE
     m_trace = NULL;
+    wave_on = false;
+    wave_next = -1;
+    wave_pc = 0;
+    wave_mmio = 0;
+    wave_difftest = false;
+#endif
     finished = false;
     pass = false;
+    run_second = 0;
+    next_ckpt = info->ckpt_interval;
+    sim_dut = this;
+    init_check(info->suite);
 }
 
 Dut::~Dut() {
+#ifdef CONFIG_WAVE
     if (m_trace) {
-        m_trace->close();
+        if (wave_on) m_trace->close();
         delete m_trace;
     }
+#endif
 }
 
 word_t Dut::reg_str2val(const char *s) {
@@ -63,27 +88,233 @@ word_t Dut::reg_str2val(const char *s) {
     return reg_id2val(id);
 }
 
-void Dut::dump() {
 #ifdef CONFIG_WAVE
-    if (m_trace && sim_time >= CONFIG_WAVE_START && sim_time <= CONFIG_WAVE_END) {
-        m_trace->dump(sim_time);
+
+// ---------------------------------------------
+// Waveform
+// ---------------------------------------------
+// Window mode: dump from --wave-start to --wave-end cycle.
+// Ring mode (--wave-trigger): keep dumping into segment files of CONFIG_WAVE_SEGMENT_CYCLE
+// cycles and only keep the latest CONFIG_WAVE_SEGMENT_KEEP files. When the trigger fires,
+// dump CONFIG_WAVE_POST_CYCLE more cycles and stop, so the files contain the history before
+// the trigger.
+
+enum {WAVE_WAIT, WAVE_WINDOW, WAVE_RING, WAVE_POST, WAVE_DONE};
+
+#define CYCLE2TICK(c)   ((vluint64_t) (c) * 2)
+#define WAVE_NEVER      ((vluint64_t) -1)
+
+extern "C" word_t wave_mmio_addr;
+
+/**
+ * name of the segment file: waveform.fst -> waveform.<seg>.fst
+ */
+static void wave_seg_name(char *buf, int size, const char *name, int seg) {
+    const char *ext = strrchr(name, '.');
+    int len = ext ? ext - name : strlen(name);
+    snprintf(buf, size, "%.*s.%d%s", len, name, seg, ext ? ext : "");
+}
+
+void Dut::wave_init(const char *name) {
+    wave_name = name;
+    const char *trig = info->wave_trigger;
+    if (!trig) {
+        wave_state = WAVE_WAIT;
+        wave_next = CYCLE2TICK(info->wave_start);
+        return;
     }
+    // trigger: pc:ADDR, mmio:ADDR or difftest
+#ifdef CONFIG_FAST_RUN
+    // fast run has no per-instruction hook to check the committed pc
+    Check(strncmp(trig, "pc:", 3) != 0, "Waveform trigger %s is not supported with CONFIG_FAST_RUN", trig);
+#endif
+#ifndef CONFIG_DIFFTEST
+    Check(strcmp(trig, "difftest") != 0, "Waveform trigger difftest requires CONFIG_DIFFTEST");
 #endif
+    if (strncmp(trig, "pc:", 3) == 0) wave_pc = strtoul(trig + 3, NULL, 0);
+    else if (strncmp(trig, "mmio:", 5) == 0) wave_mmio = strtoul(trig + 5, NULL, 0) & ~0x3;
+    else if (strcmp(trig, "difftest") == 0) wave_difftest = true;
+    else Panic("Invalid waveform trigger: %s", trig);
+    wave_mmio_addr = wave_mmio;
+    wave_state = WAVE_RING;
+    wave_seg = 0;
+    char seg[256];
+    wave_seg_name(seg, sizeof(seg), wave_name, wave_seg);
+    wave_open(seg);
+    wave_next = sim_time + CYCLE2TICK(CONFIG_WAVE_SEGMENT_CYCLE);
+    log_info("Waveform armed with trigger %s", trig);
 }
 
+void Dut::wave_open(const char *name) {
+    m_trace->open(name);
+    wave_on = true;
+}
+
+void Dut::wave_update() {
+    char seg[256];
+    switch (wave_state) {
+        case WAVE_WAIT:
+            wave_open(wave_name);
+            wave_state = WAVE_WINDOW;
+            wave_next = CYCLE2TICK(info->wave_end);
+            break;
+        case WAVE_RING:
+            // start a new segment and remove the oldest one
+            m_trace->close();
+            wave_seg++;
+            wave_seg_name(seg, sizeof(seg), wave_name, wave_seg);
+            wave_open(seg);
+            if (wave_seg >= CONFIG_WAVE_SEGMENT_KEEP) {
+                wave_seg_name(seg, sizeof(seg), wave_name, wave_seg - CONFIG_WAVE_SEGMENT_KEEP);
+                remove(seg);
+            }
+            wave_next = sim_time + CYCLE2TICK(CONFIG_WAVE_SEGMENT_CYCLE);
+            break;
+        default:
+            m_trace->close();
+            wave_on = false;
+            wave_state = WAVE_DONE;
+            wave_next = WAVE_NEVER;
+            log_info("Waveform dump stopped at cycle %ld.", sim_time / 2);
+    }
+}
+
+void Dut::wave_trigger(const char *why) {
+    if (wave_state != WAVE_RING) return;
+    int first = wave_seg >= CONFIG_WAVE_SEGMENT_KEEP ? wave_seg - CONFIG_WAVE_SEGMENT_KEEP + 1 : 0;
+    log_info("Waveform triggered by %s at cycle %ld. Segment %d to %d are kept.",
+             why, sim_time / 2, first, wave_seg);
+    wave_state = WAVE_POST;
+    wave_next = sim_time + CYCLE2TICK(CONFIG_WAVE_POST_CYCLE);
+}
+
+extern "C" void wave_mmio_hit() {
+    if (sim_dut) sim_dut->wave_trigger("MMIO access");
+}
+
+#undef CYCLE2TICK
+#undef WAVE_NEVER
+
+#endif
+
 void Dut::check() {
     // only checks if test is not finished.
     // test might be terminated by difftest if there are errors
     if (!finished) {
-        finished = check_finish(this, info->suite);
+        finished = check_finish(this);
         if (finished) {
-            pass = check_pass(this, info->suite);
+            pass = check_pass(this);
         }
     }
 }
 
+void Dut::run_start() {
+    clock_gettime(CLOCK_MONOTONIC, &run_begin);
+}
+
+void Dut::run_stop() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    run_second += (now.tv_sec - run_begin.tv_sec) + (now.tv_nsec - run_begin.tv_nsec) / 1e9;
+}
+
+#ifdef CONFIG_CHECKPOINT
+
+// ---------------------------------------------
+// Checkpoint
+// ---------------------------------------------
+// Checkpoint file: magic, sim_time, verilator model, C side state (see infra/checkpoint.c)
+
+#define CKPT_MAGIC      "NRCCKPT1"
+#define CKPT_MAGIC_LEN  8
+#define CKPT_NAME       "checkpoint.ckpt"
+
+extern "C" void ckpt_write(ckpt *c, const void *data, size_t size) {
+    reinterpret_cast<VerilatedSerialize *>(c)->write(data, size);
+}
+
+extern "C" void ckpt_read(ckpt *c, void *data, size_t size) {
+    reinterpret_cast<VerilatedDeserialize *>(c)->read(data, size);
+}
+
+void Dut::save(const char *name) {
+#if defined(CONFIG_DIFFTEST) && CONFIG_DIFFTEST_BATCH > 1
+    // compare the instructions left in the batch so the reference model is in sync with the DUT
+    if (!difftest_flush()) {
+        pass = false;
+        finished = true;
+        return;
+    }
+#endif
+    // write to a temporary file first so an interrupted save does not destroy the checkpoint
+    char tmp[256];
+    snprintf(tmp, sizeof(tmp), "%s.tmp", name);
+    VerilatedSave os;
+    os.open(tmp);
+    Check(os.isOpen(), "Failed to open checkpoint file %s", tmp);
+    os.write(CKPT_MAGIC, CKPT_MAGIC_LEN);
+    os.write(&sim_time, sizeof(sim_time));
+    save_model(os);
+    ckpt_save_state(reinterpret_cast<ckpt *>(static_cast<VerilatedSerialize *>(&os)));
+    os.close();
+    int rc = rename(tmp, name);
+    Check(rc == 0, "Failed to write checkpoint file %s", name);
+    log_info("Saved checkpoint %s at cycle %ld.", name, sim_time / 2);
+}
+
+void Dut::restore(const char *name) {
+    char magic[CKPT_MAGIC_LEN];
+    VerilatedRestore os;
+    os.open(name);
+    Check(os.isOpen(), "Failed to open checkpoint file %s", name);
+    os.read(magic, CKPT_MAGIC_LEN);
+    Check(memcmp(magic, CKPT_MAGIC, CKPT_MAGIC_LEN) == 0, "%s is not a checkpoint file", name);
+    os.read(&sim_time, sizeof(sim_time));
+    restore_model(os);
+    ckpt_restore_state(reinterpret_cast<ckpt *>(static_cast<VerilatedDeserialize *>(&os)));
+    os.close();
+    next_ckpt = sim_time / 2 + info->ckpt_interval;
+    log_info("Restored checkpoint %s at cycle %ld.", name, sim_time / 2);
+}
+
+/**
+ * Save checkpoint periodically. The previous checkpoints are kept as
+ * checkpoint.ckpt.1, checkpoint.ckpt.2, ...
+ */
+void Dut::auto_checkpoint() {
+    if (!info->ckpt_interval || finished || sim_time / 2 < next_ckpt) return;
+    char from[64], to[64];
+    for (int i = CONFIG_CHECKPOINT_KEEP - 1; i > 0; i--) {
+        if (i > 1) snprintf(from, sizeof(from), "%s.%d", CKPT_NAME, i - 1);
+        else snprintf(from, sizeof(from), "%s", CKPT_NAME);
+        snprintf(to, sizeof(to), "%s.%d", CKPT_NAME, i);
+        rename(from, to);
+    }
+    save(CKPT_NAME);
+    next_ckpt = sim_time / 2 + info->ckpt_interval;
+}
+
+#undef CKPT_MAGIC
+#undef CKPT_MAGIC_LEN
+#undef CKPT_NAME
+
+#endif
+
 bool Dut::report() {
+#if defined(CONFIG_DIFFTEST) && CONFIG_DIFFTEST_BATCH > 1
+    // Compare the instructions left in the last difftest batch. This covers all the ways the run can stop:
+    // the test finishes, the cycle budget runs out or the user quits.
+    if (!difftest_flush()) pass = false;
+#endif
     log_info("Test finished at %ld cycle.", sim_time);
+    if (run_second > 0) {
+        log_info("Simulation speed: %.0f cycles/s (%ld cycles in %.3f seconds).",
+                (sim_time / 2) / run_second, sim_time / 2, run_second);
+    }
+    report_perf();
+    if (!finished) {
+        log_err("Test did not finish in %ld cycles.", info->max_cycle);
+    }
     if (pass) {
         log_info_color("Test PASS!", ANSI_FG_GREEN);
     }
@@ -113,6 +344,38 @@ void Dut::report_reg() {
     }
 }
 
+static void report_cache(const char *name, uint64_t hit, uint64_t miss) {
+    uint64_t access = hit + miss;
+    if (access == 0) return;
+    Log("     %s hit rate: %.2f%% (%ld accesses)\n", name, hit * 100.0 / access, access);
+}
+
+void Dut::report_perf() {
+    static const char *name[NUM_PERF_COUNTER] = {
+        "cycle", "instret", "ifu wait", "load wait", "store wait", "muldiv busy", "bus stall",
+        "icache hit", "icache miss", "dcache hit", "dcache miss", "dcache wb", "branch", "mispredict"
+    };
+    uint64_t cycle = perf_counter(PERF_CYCLE);
+    uint64_t instret = perf_counter(PERF_INSTRET);
+    if (cycle == 0) return;
+    Log("Performance counter\n");
+    Log("     Counter          Value    %% cycle\n");
+    Log("     ------------ ------------ -------\n");
+    for (int i = 0; i < NUM_PERF_COUNTER; i++) {
+        uint64_t value = perf_counter(i);
+        Log("     %-12s %12ld %6.2f%%\n", name[i], value, value * 100.0 / cycle);
+    }
+    Log("     IPC: %.3f  CPI: %.3f\n", (double)instret / cycle, instret ? (double)cycle / instret : 0.0);
+    report_cache("I-cache", perf_counter(PERF_ICACHE_HIT), perf_counter(PERF_ICACHE_MISS));
+    report_cache("D-cache", perf_counter(PERF_DCACHE_HIT), perf_counter(PERF_DCACHE_MISS));
+    uint64_t branch = perf_counter(PERF_BRANCH);
+    uint64_t mispredict = perf_counter(PERF_MISPREDICT);
+    if (branch) {
+        Log("     Branch prediction accuracy: %.2f%% (%ld branches)\n",
+            (branch - mispredict) * 100.0 / branch, branch);
+    }
+}
+
 void Dut::trace(word_t pc, word_t nxtpc, word_t inst) {
 #ifdef CONFIG_ITRACE
     itrace_write(pc, inst);
@@ -122,14 +385,22 @@ void Dut::trace(word_t pc, word_t nxtpc, word_t inst) {
 #endif
 }
 
-void Dut::difftest(word_t pc) {
+void Dut::difftest(word_t pc, word_t inst) {
 #ifdef CONFIG_DIFFTEST
+    if (!info->ref) return;
     read_reg(); // read the register from DUT
+#if CONFIG_DIFFTEST_BATCH > 1
+    bool diffresult = difftest_step(regs, pc, inst);
+#else
     ref_exec(1, regs, &pc);
     bool diffresult = difftest_compare(regs, pc);
+#endif
     if (!diffresult) {
         pass = false;
         finished = true;
+    #ifdef CONFIG_WAVE
+        if (wave_difftest) wave_trigger("difftest failure");
+    #endif
     }
 #endif
 }
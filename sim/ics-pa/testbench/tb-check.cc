@@ -21,6 +21,12 @@
 extern bool dpi_ebreak;
 extern bool NRC_SDL_quit;
 
+typedef bool (*check_func)(Dut *top);
+
+// selected once by init_check so the finish check is cheap enough to run every cycle
+static check_func finish_func = NULL;
+static check_func pass_func = NULL;
+
 // ---------------------------------------------
 // Check test finished or not
 // ---------------------------------------------
@@ -33,13 +39,10 @@ static bool ics_check_finish(Dut *top) {
 }
 
 /**
- * select and run different check finish function based on test suite
+ * run the check finish function of the test suite
  */
-bool check_finish(Dut *top, const char *suite) {
-    if (NRC_SDL_quit) return true;
-    if (strcmp(suite, ICS2023) == 0)
-        return ics_check_finish(top);
-    assert(0);
+bool check_finish(Dut *top) {
+    return NRC_SDL_quit || finish_func(top);
 }
 
 // ---------------------------------------------
@@ -54,12 +57,21 @@ static bool ics_check_pass(Dut *top) {
 }
 
 /**
- * select and run different check pass function based on test suite
+ * run the check pass function of the test suite
+ */
+bool check_pass(Dut *top) {
+    return NRC_SDL_quit || pass_func(top);
+}
+
+/**
+ * select the check functions based on test suite
  */
-bool check_pass(Dut *top, const char *suite) {
-    if (NRC_SDL_quit) return true;
-    if (strcmp(suite, ICS2023) == 0)
-        return ics_check_pass(top);
+void init_check(const char *suite) {
+    if (strcmp(suite, ICS2023) == 0) {
+        finish_func = ics_check_finish;
+        pass_func = ics_check_pass;
+        return;
+    }
     assert(0);
 }
 
@@ -21,8 +21,10 @@ extern "C" {
     void close_trace();
     void init_disasm();
     void init_device();
-    size_t load_image(const char *img);
-    void init_difftest(char *ref, size_t mem_size);
+    void init_mem(size_t size);
+    bool is_elf(const char *name);
+    size_t load_image(const char *img, word_t *entry);
+    void init_difftest(char *ref, size_t mem_size, word_t entry);
 }
 
 // ------------------------------------
@@ -33,19 +35,21 @@ extern "C" {
 static test_info info = {
     .elf=NULL,
     .ref=NULL,
+    .msize=MSIZE,
+    .max_cycle=0,
+    .restore=NULL,
+    .ckpt_interval=0,
+#ifdef CONFIG_WAVE
+    .wave=NULL,
+    .wave_start=CONFIG_WAVE_START,
+    .wave_end=CONFIG_WAVE_END,
+    .wave_trigger=NULL,
+#endif
 };
 
-// File pointer for log
-const char itrace_log[] = "itrace.log";
-const char mtrace_log[] = "mtrace.log";
-const char ftrace_log[] = "ftrace.log";
-const char strace_log[] = "strace.log";
+// File pointer for log. The trace logs are written by the trace sink
 const char log_name[]   = "run.log";
 
-FILE *itrace_fp = NULL;
-FILE *mtrace_fp = NULL;
-FILE *ftrace_fp = NULL;
-FILE *strace_fp = NULL;
 FILE *log_fp = NULL;
 
 // ------------------------------------
@@ -58,12 +62,28 @@ FILE *log_fp = NULL;
 static void print_usage(const char *prog) {
     printf("Usage: \n\t%s args [options]\n\n", prog);
     printf("REQUIRED ARGS\n\n");
-    printf("\t-i,--image IMAGE      Binary Image file for the program\n");
+    printf("\t-i,--image IMAGE      Image file for the program. ELF file or binary file\n");
     printf("\t-s,--suite SUITE      Test Suite\n");
     printf("\t-t,--test TEST        Test Name\n");
     printf("\t-d,--dut DUT          DUT Top module name\n");
-    printf("\t--elf ELF             ELF file for the program\n");
-    printf("\t--ref REF_SO          Reference for diff test\n");
+    printf("\t--elf ELF             ELF file for the program. Multiple ELF files (kernel and apps) can be\n");
+    printf("\t                      specified as ELF[@BASE],ELF[@BASE] for ftrace\n");
+    printf("\t                      Default to the image if it is an ELF file\n");
+    printf("\t--ref REF_SO          Reference for diff test. Difftest is disabled without it\n");
+    printf("\t--msize SIZE          Memory size. Accept K/M/G suffix. At most %dM. Default: %dM\n",
+           (int) ((MMIO_BASE - MEM_BASE) >> 20), MSIZE >> 20);
+    printf("\t--max-cycle N         Fail the test if it does not finish in N cycles. Accept K/M/G suffix\n");
+#ifdef CONFIG_WAVE
+    printf("\t--wave FST            Dump waveform to the FST file\n");
+    printf("\t--wave-start N        Waveform start cycle. Default: %d\n", CONFIG_WAVE_START);
+    printf("\t--wave-end N          Waveform end cycle. Default: %d\n", CONFIG_WAVE_END);
+    printf("\t--wave-trigger TRIG   Keep the recent waveform in segment files and stop dumping after the trigger.\n");
+    printf("\t                      TRIG: pc:ADDR (not with fast run), mmio:ADDR or difftest\n");
+#endif
+#ifdef CONFIG_CHECKPOINT
+    printf("\t--restore CKPT        Restore the simulation from checkpoint file\n");
+    printf("\t--ckpt-interval N     Save checkpoint every N cycles. Accept K/M/G suffix\n");
+#endif
     printf("\n");
 }
 
@@ -90,6 +110,22 @@ static void check_args(const char *prog) {
     }
 }
 
+/**
+ * Parse size with optional K/M/G suffix
+ */
+static size_t parse_size(const char *s) {
+    char *end;
+    size_t size = strtoul(s, &end, 0);
+    switch (*end) {
+        case 'g': case 'G': size <<= 30; break;
+        case 'm': case 'M': size <<= 20; break;
+        case 'k': case 'K': size <<= 10; break;
+        case '\0': break;
+        default: Panic("Invalid size: %s", s);
+    }
+    return size;
+}
+
 /**
  * Parse argument
  */
@@ -101,6 +137,18 @@ int parse_args(int argc, char *argv[]) {
         {"dut",   required_argument, 0, 'd'},
         {"elf",   required_argument, 0, '1'},
         {"ref",   required_argument, 0, '2'},
+        {"msize", required_argument, 0, '3'},
+        {"max-cycle", required_argument, 0, 'm'},
+#ifdef CONFIG_WAVE
+        {"wave", required_argument, 0, '6'},
+        {"wave-start", required_argument, 0, '7'},
+        {"wave-end", required_argument, 0, '8'},
+        {"wave-trigger", required_argument, 0, '9'},
+#endif
+#ifdef CONFIG_CHECKPOINT
+        {"restore", required_argument, 0, '4'},
+        {"ckpt-interval", required_argument, 0, '5'},
+#endif
         // Add more option here if needed
         {0      , 0                , 0,  0 },
     };
@@ -114,6 +162,14 @@ int parse_args(int argc, char *argv[]) {
             case 'd': info.dut = optarg; break;
             case '1': info.elf = optarg; break;
             case '2': info.ref = optarg; break;
+            case '3': info.msize = parse_size(optarg); break;
+            case 'm': info.max_cycle = parse_size(optarg); break;
+            case '4': info.restore = optarg; break;
+            case '5': info.ckpt_interval = parse_size(optarg); break;
+            case '6': info.wave = optarg; break;
+            case '7': info.wave_start = parse_size(optarg); break;
+            case '8': info.wave_end = parse_size(optarg); break;
+            case '9': info.wave_trigger = optarg; break;
             default:
                 print_usage(argv[0]);
                 exit(0);
@@ -129,29 +185,9 @@ int parse_args(int argc, char *argv[]) {
 static void init_log() {
     log_fp = fopen(log_name, "w");
     assert(log_fp);
-#ifdef CONFIG_ITRACE_WRITE_LOG
-    itrace_fp = fopen(itrace_log, "w");
-    Check(itrace_fp, "Failed to open %s", itrace_log);
-#endif
-#ifdef CONFIG_MTRACE_WRITE_LOG
-    mtrace_fp = fopen(mtrace_log, "w");
-    Check(mtrace_fp, "Failed to open %s", mtrace_log);
-#endif
-#ifdef CONFIG_FTRACE_WRITE_LOG
-    ftrace_fp = fopen(ftrace_log, "w");
-    Check(ftrace_fp, "Failed to open %s", ftrace_log);
-#endif
-#ifdef CONFIG_STRACE
-    strace_fp = fopen(strace_log, "w");
-    Check(strace_fp, "Failed to open %s", strace_log);
-#endif
 }
 
 static void close_log() {
-    if (itrace_fp) fclose(itrace_fp);
-    if (mtrace_fp) fclose(mtrace_fp);
-    if (ftrace_fp) fclose(ftrace_fp);
-    if (strace_fp) fclose(strace_fp);
     if (log_fp) fclose(log_fp);
     // remove ANSI color coding in log file
     char cmd[] = "sed -i 's/\x1b\[[0-9;]*m//g' run.log"; // Note: the log name is hard coded here
@@ -164,10 +200,11 @@ static void close_log() {
  */
 static Dut *select_dut(int argc, char *argv[], test_info *info) {
     Dut *dut = NULL;
-    if (strcmp(info->dut, "CoreNSoC") == 0)
-        dut = new CoreNSoC(argc, argv, info);
+    // only the design selected at compile time is built into the executable
+    if (strcmp(info->dut, TOP_NAME(TOP)) == 0)
+        dut = new TOP(argc, argv, info);
     else {
-        log_err("Undefined dut: %s", info->dut);
+        log_err("Undefined dut: %s. The simulator is built for %s", info->dut, TOP_NAME(TOP));
         exit(0);
     }
     return dut;
@@ -179,18 +216,26 @@ static Dut *select_dut(int argc, char *argv[], test_info *info) {
 
 int tb_exec(int argc, char *argv[]) {
 
+    word_t entry;
     parse_args(argc, argv);
     init_log();
+    if (!info.elf && is_elf(info.image)) info.elf = info.image;
     init_trace(info.elf);
     init_device();
     Dut *dut = select_dut(argc, argv, &info);
-    size_t mem_size = load_image(info.image);
+    init_mem(info.msize);
+    size_t mem_size = load_image(info.image, &entry);
 #ifdef CONFIG_DIFFTEST
-    init_difftest(info.ref, mem_size);
+    if (info.ref) init_difftest(info.ref, mem_size, entry);
+    else log_warn("No reference model is given. Difftest is disabled");
 #endif
-    dut->init_trace("waveform.vcd", 99);
+    if (info.wave) dut->init_trace(info.wave, 99);
+    dut->set_reset_vector(entry);
     dut->reset();
-    dut->run(-1); // run till the end of the test
+#ifdef CONFIG_CHECKPOINT
+    if (info.restore) dut->restore(info.restore);
+#endif
+    dut->run(info.max_cycle ? info.max_cycle : -1); // run till the end of the test or the cycle budget
     bool success = dut->report();
 
     close_trace();
@@ -0,0 +1,54 @@
+// ------------------------------------------------------------------------------------------------
+// Copyright (c) 2023. Heqing Huang (feipenghhq@gmail.com)
+//
+// Project: NRC
+// Author: Heqing Huang
+// Date Created: 10/18/2026
+// ------------------------------------------------------------------------------------------------
+// itrace-decode: Decode the binary instruction trace log (itrace.bin) into text
+// Usage: itrace-decode itrace.bin [output]
+// ------------------------------------------------------------------------------------------------
+
+#include "common.h"
+#include "itrace.h"
+
+FILE *log_fp = NULL;
+
+void init_disasm();
+char *disasm(word_t *inst, word_t pc);
+
+#define READ_BATCH 4096
+
+int main(int argc, char *argv[]) {
+    log_fp = stderr;
+    if (argc < 2) {
+        printf("Usage: \n\t%s itrace.bin [output]\n\n", argv[0]);
+        return 1;
+    }
+    FILE *in = fopen(argv[1], "rb");
+    Check(in, "Can't open file %s", argv[1]);
+    FILE *out = argc > 2 ? fopen(argv[2], "w") : stdout;
+    Check(out, "Can't open file %s", argv[2]);
+
+    char magic[ITRACE_MAGIC_LEN];
+    size_t rc = fread(magic, sizeof(char), ITRACE_MAGIC_LEN, in);
+    Check(rc == ITRACE_MAGIC_LEN && memcmp(magic, ITRACE_MAGIC, ITRACE_MAGIC_LEN) == 0,
+          "%s is not an instruction trace file", argv[1]);
+
+    init_disasm();
+    static itrace_rec recs[READ_BATCH];
+    while ((rc = fread(recs, sizeof(itrace_rec), READ_BATCH, in)) > 0) {
+        for (size_t i = 0; i < rc; i++) {
+            if (INST_SIZE(recs[i].inst) == 4)
+                fprintf(out, "0x%08x: 0x%08x%s\n", recs[i].pc, recs[i].inst, disasm(&recs[i].inst, recs[i].pc));
+            else
+                fprintf(out, "0x%08x: 0x%04x    %s\n", recs[i].pc, recs[i].inst, disasm(&recs[i].inst, recs[i].pc));
+        }
+    }
+
+    fclose(in);
+    if (out != stdout) fclose(out);
+    return 0;
+}
+
+#undef READ_BATCH
@@ -10,10 +10,13 @@
  * ------------------------------------------------------------------------------------------------
  */
 
+#include <time.h>
 #include <verilated.h>
-#include <verilated_vcd_c.h>
 #include <VysyxSoCFull.h>
 #include "autoconf.h"
+#ifdef CONFIG_WAVE
+#include <verilated_fst_c.h>
+#endif
 #include "debug.h"
 #include "soc.h"
 
@@ -67,7 +70,7 @@ public:
     bool check_finish();
 
     #ifdef CONFIG_WAVE
-    VerilatedVcdC *m_trace;     // Waveform trace
+    VerilatedFstC *m_trace;     // Waveform trace
     void init_dump(const char *name, int level);
     void dump();
     #endif
@@ -81,12 +84,15 @@ Testbench::Testbench(int argc, char *argv[]) {
     reset_cycle = 10;
     fill_flash();
     #ifdef CONFIG_WAVE
-    VerilatedVcdC *m_trace;
-    init_dump("waveform.vcd", 99);
+    init_dump("waveform.fst", 99);
     #endif
 }
 
 Testbench::~Testbench() {
+    #ifdef CONFIG_WAVE
+    m_trace->close();
+    delete m_trace;
+    #endif
     delete inst;
     delete top;
 }
@@ -145,27 +151,36 @@ bool Testbench::check_finish() {
 
 void Testbench::run() {
     bool finish = false;
+    struct timespec begin, end;
     load();
     reset();
+    clock_gettime(CLOCK_MONOTONIC, &begin);
     while (!finish) {
         clk_tick();
         clk_tick();
         finish = check_finish();
     }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double second = (end.tv_sec - begin.tv_sec) + (end.tv_nsec - begin.tv_nsec) / 1e9;
     log_info("Test Finished");
+    if (second > 0) {
+        log_info("Simulation speed: %.0f cycles/s (%ld cycles in %.3f seconds).",
+                (sim_time / 2) / second, (long)(sim_time / 2), second);
+    }
 }
 
 #ifdef CONFIG_WAVE
 
 void Testbench::init_dump(const char *name, int level) {
     Verilated::traceEverOn(true);
-    m_trace = new VerilatedVcdC;
+    m_trace = new VerilatedFstC;
     top->trace(m_trace, level);
     m_trace->open(name);
 }
 
 void Testbench::dump() {
-    if (m_trace && sim_time >= CONFIG_WAVE_START && sim_time <= CONFIG_WAVE_END) {
+    // the window is in cycles and sim_time counts half cycles
+    if (sim_time >= 2 * (vluint64_t) CONFIG_WAVE_START && sim_time <= 2 * (vluint64_t) CONFIG_WAVE_END) {
         m_trace->dump(sim_time);
     }
 }
@@ -190,4 +205,5 @@ void fill_flash() {
 int main(int argc, char *argv[]) {
     Testbench *tb = new Testbench(argc, argv);
     tb->run();
+    delete tb;
 }
\ No newline at end of file